@@ -11,5 +11,5 @@ if [ ! -f "$SRC_FILE" ]; then
 fi
 
 echo "[info] Building flightsim from $SRC_FILE" >&2
-g++ -std=c++17 "$SRC_FILE" -o "$OUTPUT"
+g++ -std=c++17 -pthread "$SRC_FILE" -o "$OUTPUT"
 echo "[done] Built $OUTPUT" >&2
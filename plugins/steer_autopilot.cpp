@@ -0,0 +1,59 @@
+// Example controller plugin: steers straight at the next ring, banking into
+// the turn, at full throttle. Build it with the flightsim CMake
+// project (target steer_autopilot) and run
+//   ./flightsim --plugin ./libsteer_autopilot.so
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "flightsim_plugin.h"
+
+namespace {
+
+constexpr double kCruiseThrottle = 1.0;  // lift is weak; thrust carries most of the weight
+constexpr double kBankPerBearing = 0.8;  // roll (rad) per rad of heading error
+constexpr double kPitchTrim = 0.3;       // nose-up attitude (rad) that holds altitude
+constexpr double kClimbDamping = 0.05;   // rad of pitch per m/s of vertical speed
+
+void steer(const FlightsimState &state, FlightsimInput &out) {
+    out.throttle_delta = kCruiseThrottle - state.throttle;
+    if (state.ring[3] <= 0.0) {  // course done: wings level
+        out.pitch_delta = -state.pitch;
+        out.yaw_delta = 0.0;
+        out.roll_delta = -state.roll;
+        return;
+    }
+    // Ring offset in the aircraft's heading frame.
+    const double dx = state.ring[0] - state.position[0];
+    const double dy = state.ring[1] - state.position[1];
+    const double dz = state.ring[2] - state.position[2];
+    const double c = std::cos(state.yaw);
+    const double s = std::sin(state.yaw);
+    const double side = dx * c - dz * s;
+    const double ahead = dx * s + dz * c;
+    const double bearing = std::atan2(side, ahead);
+    const double climb = std::atan2(dy, std::hypot(side, ahead));
+
+    out.yaw_delta = bearing;
+    out.roll_delta = kBankPerBearing * bearing - state.roll;
+    // Positive pitch is nose-down.
+    out.pitch_delta = -(kPitchTrim + climb - kClimbDamping * state.velocity[1]) - state.pitch;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t flightsim_plugin_abi(void) { return FLIGHTSIM_PLUGIN_ABI; }
+
+const char *flightsim_plugin_name(void) { return "steer_autopilot"; }
+
+// The simulator clamps every command to its per-tick limit, so the plugin can
+// simply ask for the full correction.
+void flightsim_control(const FlightsimState *states, FlightsimInput *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        steer(states[i], out[i]);
+    }
+}
+
+}  // extern "C"
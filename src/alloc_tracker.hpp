@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace sim {
+namespace alloc {
+
+// Heap accounting by subsystem. The executable that wants it replaces the
+// global operator new/delete (see main.cpp) and forwards to onAllocate/
+// onFree; everything here is lock-free and never allocates itself, so it is
+// safe to call from inside the allocator. Code marks what it is doing with a
+// TagScope, and a NoAllocScope turns any allocation on that thread into a
+// recorded violation, which is how the steady-state check is enforced.
+
+enum Tag : std::size_t {
+    kUntagged,
+    kIo,
+    kParse,
+    kHud,
+    kStep,
+    kTelemetry,
+    kDataset,
+    kTraining,
+    kTagCount
+};
+
+constexpr std::array<const char *, kTagCount> kTagNames{"untagged", "io",        "parse",   "hud",
+                                                        "step",     "telemetry", "dataset", "training"};
+
+struct Counters {
+    std::array<std::atomic<std::uint64_t>, kTagCount> allocations{};
+    std::array<std::atomic<std::uint64_t>, kTagCount> bytes{};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> violations{0};
+};
+
+inline Counters &counters() {
+    static Counters instance;
+    return instance;
+}
+
+inline Tag &currentTag() {
+    thread_local Tag tag = kUntagged;
+    return tag;
+}
+
+inline bool &allocationForbidden() {
+    thread_local bool forbidden = false;
+    return forbidden;
+}
+
+inline void onAllocate(std::size_t size) {
+    Counters &c = counters();
+    const Tag tag = currentTag();
+    c.allocations[tag].fetch_add(1, std::memory_order_relaxed);
+    c.bytes[tag].fetch_add(size, std::memory_order_relaxed);
+    if (allocationForbidden()) {
+        c.violations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void onFree() { counters().frees.fetch_add(1, std::memory_order_relaxed); }
+
+inline std::uint64_t totalAllocations() {
+    std::uint64_t total = 0;
+    for (const auto &count : counters().allocations) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+class TagScope {
+  public:
+    explicit TagScope(Tag tag) : previous_(currentTag()) { currentTag() = tag; }
+    ~TagScope() { currentTag() = previous_; }
+
+    TagScope(const TagScope &) = delete;
+    TagScope &operator=(const TagScope &) = delete;
+
+  private:
+    Tag previous_;
+};
+
+class NoAllocScope {
+  public:
+    NoAllocScope() : previous_(allocationForbidden()) { allocationForbidden() = true; }
+    ~NoAllocScope() { allocationForbidden() = previous_; }
+
+    NoAllocScope(const NoAllocScope &) = delete;
+    NoAllocScope &operator=(const NoAllocScope &) = delete;
+
+  private:
+    bool previous_;
+};
+
+inline void report(std::ostream &out) {
+    const Counters &c = counters();
+    out << "\n=== 힙 할당 (서브시스템별) ===\n";
+    for (std::size_t t = 0; t < kTagCount; ++t) {
+        const std::uint64_t n = c.allocations[t].load(std::memory_order_relaxed);
+        if (n == 0) {
+            continue;
+        }
+        out << std::left << std::setw(12) << kTagNames[t] << std::right << std::setw(10) << n << " 회"
+            << std::setw(14) << c.bytes[t].load(std::memory_order_relaxed) << " B\n";
+    }
+    out << "해제 " << c.frees.load(std::memory_order_relaxed) << " 회\n";
+}
+
+}  // namespace alloc
+}  // namespace sim
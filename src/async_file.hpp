@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define SIM_HAS_IO_URING 1
+#endif
+#endif
+#endif
+#ifndef SIM_HAS_IO_URING
+#define SIM_HAS_IO_URING 0
+#endif
+
+namespace sim {
+
+enum class IoBackend { kAuto, kUring, kThread };
+
+// Append-only file written without blocking the caller: write() hands over
+// one buffer and returns at once; the buffer must stay untouched until busy()
+// turns false. At most one write is in flight, which is all a double-buffered
+// producer needs. On Linux the write goes through an io_uring (raw syscalls,
+// no liburing); elsewhere, or when the kernel refuses a ring or cannot do
+// IORING_OP_WRITE (before 5.6), a worker thread does the write instead.
+class AsyncFile {
+  public:
+    AsyncFile(const std::string &path, IoBackend backend = IoBackend::kAuto) {
+#if SIM_HAS_IO_URING
+        if (backend != IoBackend::kThread && openUring(path)) {
+            return;
+        }
+        if (backend == IoBackend::kUring) {
+            return;
+        }
+#endif
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            return;
+        }
+        uring_ = false;
+        ok_ = true;
+        worker_ = std::thread([this] { runWorker(); });
+    }
+
+    AsyncFile(const AsyncFile &) = delete;
+    AsyncFile &operator=(const AsyncFile &) = delete;
+
+    ~AsyncFile() {
+        wait();
+        if (worker_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_one();
+            worker_.join();
+        }
+#if SIM_HAS_IO_URING
+        closeUring();
+#endif
+    }
+
+    bool ok() const { return ok_ && !failed_.load(std::memory_order_acquire); }
+    const char *backend() const { return uring_ ? "io_uring" : "thread"; }
+
+    // True while the last write is still in flight. Never blocks: with
+    // io_uring this only reads the completion ring.
+    bool busy() {
+#if SIM_HAS_IO_URING
+        if (uring_) {
+            reap();
+            return remaining_ > 0;
+        }
+#endif
+        return busy_.load(std::memory_order_acquire);
+    }
+
+    // Queues data for the end of the file. Returns false (and writes nothing)
+    // if the previous write has not finished or the file failed.
+    bool write(const void *data, std::size_t size) {
+        if (!ok() || busy()) {
+            return false;
+        }
+        if (size == 0) {
+            return true;
+        }
+#if SIM_HAS_IO_URING
+        if (uring_) {
+            data_ = static_cast<const unsigned char *>(data);
+            remaining_ = size;
+            return submit();
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = static_cast<const char *>(data);
+            jobSize_ = size;
+            busy_.store(true, std::memory_order_release);
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    // Blocks until the write in flight has finished; for shutdown and
+    // explicit flushes, never the per-tick path.
+    bool wait() {
+#if SIM_HAS_IO_URING
+        if (uring_) {
+            while (!failed_.load(std::memory_order_relaxed) && busy()) {
+                enter(0, 1, IORING_ENTER_GETEVENTS);
+            }
+            return ok();
+        }
+#endif
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&] { return !busy_.load(std::memory_order_acquire); });
+        return ok();
+    }
+
+  private:
+    bool ok_{false};
+    bool uring_{false};
+    std::atomic<bool> failed_{false};
+
+    // Thread fallback.
+    std::ofstream out_;
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::atomic<bool> busy_{false};
+    const char *job_{nullptr};
+    std::size_t jobSize_{0};
+    bool stopping_{false};
+
+    void runWorker() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stopping_ || job_ != nullptr; });
+            if (job_ == nullptr) {
+                return;
+            }
+            const char *data = job_;
+            const std::size_t size = jobSize_;
+            lock.unlock();
+            out_.write(data, static_cast<std::streamsize>(size));
+            out_.flush();
+            if (!out_) {
+                failed_.store(true, std::memory_order_release);
+            }
+            lock.lock();
+            job_ = nullptr;
+            busy_.store(false, std::memory_order_release);
+            done_.notify_all();
+        }
+    }
+
+#if SIM_HAS_IO_URING
+    int fd_{-1};
+    int ring_{-1};
+    void *sqRing_{nullptr};
+    void *cqRing_{nullptr};
+    std::size_t sqRingBytes_{0};
+    std::size_t cqRingBytes_{0};
+    io_uring_sqe *sqes_{nullptr};
+    std::size_t sqesBytes_{0};
+    unsigned *sqTail_{nullptr};
+    unsigned *sqMask_{nullptr};
+    unsigned *sqArray_{nullptr};
+    unsigned *cqHead_{nullptr};
+    unsigned *cqTail_{nullptr};
+    unsigned *cqMask_{nullptr};
+    io_uring_cqe *cqes_{nullptr};
+    const unsigned char *data_{nullptr};
+    std::size_t remaining_{0};  // bytes of the current write not yet on file
+    std::uint64_t offset_{0};   // where the next write lands
+
+    static unsigned *field(void *ring, std::uint32_t offset) {
+        return reinterpret_cast<unsigned *>(static_cast<unsigned char *>(ring) + offset);
+    }
+
+    int enter(unsigned submit, unsigned complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring_, submit, complete, flags, nullptr, 0));
+    }
+
+    bool openUring(const std::string &path) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_ = static_cast<int>(::syscall(__NR_io_uring_setup, 4, &params));
+        if (ring_ < 0) {
+            return false;
+        }
+        if (!supportsWrite()) {
+            closeUring();
+            return false;
+        }
+        sqRingBytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqRingBytes_ = cqRingBytes_ = std::max(sqRingBytes_, cqRingBytes_);
+        }
+        sqRing_ = ::mmap(nullptr, sqRingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_,
+                         IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            sqRing_ = nullptr;
+            closeUring();
+            return false;
+        }
+        if (single) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = ::mmap(nullptr, cqRingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_,
+                             IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED) {
+                cqRing_ = nullptr;
+                closeUring();
+                return false;
+            }
+        }
+        sqesBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = ::mmap(nullptr, sqesBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_,
+                            IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            closeUring();
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+        sqTail_ = field(sqRing_, params.sq_off.tail);
+        sqMask_ = field(sqRing_, params.sq_off.ring_mask);
+        sqArray_ = field(sqRing_, params.sq_off.array);
+        cqHead_ = field(cqRing_, params.cq_off.head);
+        cqTail_ = field(cqRing_, params.cq_off.tail);
+        cqMask_ = field(cqRing_, params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(static_cast<unsigned char *>(cqRing_) + params.cq_off.cqes);
+
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            closeUring();
+            return false;
+        }
+        uring_ = true;
+        ok_ = true;
+        return true;
+    }
+
+    // A ring alone does not mean the write path works: IORING_OP_WRITE and
+    // IOSQE_ASYNC arrived in 5.6, together with IORING_REGISTER_PROBE, so
+    // an older kernel fails the probe itself.
+    bool supportsWrite() {
+        constexpr unsigned kOps = 256;
+        alignas(io_uring_probe) unsigned char buffer[sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op)] = {};
+        auto *probe = reinterpret_cast<io_uring_probe *>(buffer);
+        if (::syscall(__NR_io_uring_register, ring_, IORING_REGISTER_PROBE, probe, kOps) < 0) {
+            return false;
+        }
+        return probe->last_op >= IORING_OP_WRITE && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    void closeUring() {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqesBytes_);
+            sqes_ = nullptr;
+        }
+        if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingBytes_);
+        }
+        if (sqRing_ != nullptr) {
+            ::munmap(sqRing_, sqRingBytes_);
+        }
+        sqRing_ = cqRing_ = nullptr;
+        if (ring_ >= 0) {
+            ::close(ring_);
+            ring_ = -1;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // One IORING_OP_WRITE for whatever is left of the current buffer. The
+    // request is marked async so the kernel hands it to its own workers
+    // instead of copying into the page cache inside io_uring_enter.
+    bool submit() {
+        const unsigned tail = *sqTail_;
+        const unsigned index = tail & *sqMask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.flags = IOSQE_ASYNC;
+        sqe.fd = fd_;
+        sqe.addr = reinterpret_cast<std::uint64_t>(data_);
+        sqe.len = static_cast<std::uint32_t>(std::min<std::size_t>(remaining_, 1u << 30));
+        sqe.off = offset_;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        int submitted = 0;
+        do {
+            submitted = enter(1, 0, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted != 1) {
+            remaining_ = 0;
+            failed_.store(true, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    void reap() {
+        unsigned head = *cqHead_;
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const std::int32_t result = cqes_[head & *cqMask_].res;
+            ++head;
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            if (result == -EINTR || result == -EAGAIN) {
+                submit();
+            } else if (result <= 0) {
+                remaining_ = 0;
+                failed_.store(true, std::memory_order_release);
+            } else {
+                // A short write continues where it stopped.
+                const auto written = static_cast<std::size_t>(result);
+                data_ += written;
+                offset_ += written;
+                remaining_ -= written;
+                if (remaining_ > 0) {
+                    submit();
+                }
+            }
+        }
+    }
+#endif
+};
+
+}  // namespace sim
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "compact_state.hpp"
+#include "perf_counters.hpp"
+#include "scenario.hpp"
+#include "simulator.hpp"
+#include "trace.hpp"
+
+namespace sim {
+
+// One episode waiting for a lane; the tag is handed back to the driver. With
+// a scenario the lane starts from its initial state and runs its rules after
+// every step; the episode also ends when the scenario decides an outcome.
+struct BatchEpisode {
+    std::shared_ptr<const Course> course;
+    std::uint32_t tag{0};
+    std::shared_ptr<const Scenario> scenario;
+};
+
+struct BatchStats {
+    std::uint64_t ticks{0};
+    std::uint64_t laneSteps{0};  // aircraft actually stepped, summed over ticks
+    std::uint64_t episodes{0};
+    std::uint64_t compactions{0};
+    std::size_t lanes{0};
+    std::size_t stateBytes{0};  // per-lane flight state streamed each tick
+
+    // Share of lane slots that did useful work.
+    double utilization() const {
+        const double capacity = static_cast<double>(ticks) * static_cast<double>(lanes);
+        return capacity > 0.0 ? static_cast<double>(laneSteps) / capacity : 0.0;
+    }
+};
+
+// One live lane as handed to BatchDriver::actAll.
+struct LaneView {
+    std::size_t lane{0};
+    const FlightState *state{nullptr};
+    const Course *course{nullptr};
+    const std::uint64_t *passed{nullptr};
+    std::size_t ringsLeft{0};
+};
+
+// Callbacks from BatchSimulator::run. Lane numbers identify a slot, not an
+// episode: a lane is reused once its episode finishes, and compaction may
+// move a live episode to a lower lane (reported through moved()).
+class BatchDriver {
+  public:
+    virtual ~BatchDriver() = default;
+
+    virtual void started(std::size_t lane, std::uint32_t tag, const FlightState &state, const Course &course,
+                         const std::uint64_t *passed) = 0;
+    // ringsLeft is the lane's count of rings not yet passed.
+    virtual Input act(std::size_t lane, const FlightState &state, const Course &course, const std::uint64_t *passed,
+                      std::size_t ringsLeft) = 0;
+    // Returning false ends the episode after this step.
+    virtual bool stepped(std::size_t lane, const FlightState &state, const Course &course,
+                         const std::uint64_t *passed) = 0;
+    virtual void finished(std::size_t lane, std::uint32_t tag, const FlightState &state) = 0;
+    virtual void moved(std::size_t from, std::size_t to) = 0;
+
+    // Drivers that decide for the whole batch at once (e.g. an external
+    // controller with a per-call cost) return true here; run() then calls
+    // actAll() once per tick with every live lane, in stepping order, instead
+    // of act() per lane.
+    virtual bool batched() const { return false; }
+    virtual void actAll(const LaneView *lanes, std::size_t count, Input *out) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = act(lanes[i].lane, *lanes[i].state, *lanes[i].course, lanes[i].passed, lanes[i].ringsLeft);
+        }
+    }
+};
+
+// How lanes keep their flight state between ticks.
+enum class StateStorage {
+    kFull,     // FlightState, exact
+    kCompact,  // CompactFlightState: 28 bytes instead of 96, bounded quantisation error
+};
+
+// Steps many independent aircraft in lockstep. Only lanes on the active list
+// are touched each tick, so an aircraft that ran out of fuel, finished its
+// course or hit the step limit costs nothing once retired. Freed lanes are
+// refilled from the pending queue before the next tick (auto-reset); when the
+// queue is empty and the survivors are scattered across the lane range, they
+// are compacted down into a dense prefix so the tail of the run stays
+// cache-friendly. Lane storage, including the ring bitsets, is reused across
+// episodes, so a warmed-up batch does not allocate. With compact storage
+// each lane is unpacked once per tick and packed again after the step.
+// Lanes hold whole FlightState records and a scalar loop steps them one at a
+// time; the batch buys dense memory access and one driver call per tick, not
+// SIMD. Timed scenario rules of every lane share one timing wheel keyed by
+// batch tick.
+class BatchSimulator {
+  public:
+    BatchSimulator(std::size_t lanes, std::size_t maxSteps, double dt, StateStorage storage = StateStorage::kFull)
+        : maxSteps_(maxSteps),
+          dt_(dt),
+          compact_(storage == StateStorage::kCompact),
+          states_(compact_ ? 0 : lanes),
+          packed_(compact_ ? lanes : 0),
+          courses_(lanes),
+          scenarios_(lanes),
+          scenarioStates_(lanes),
+          passed_(lanes),
+          remaining_(lanes, 0),
+          steps_(lanes, 0),
+          tags_(lanes, 0),
+          generations_(lanes, 0),
+          due_(lanes, 0),
+          occupied_(lanes, 0),
+          views_(lanes),
+          inputs_(lanes),
+          unpacked_(compact_ ? lanes : 0) {
+        active_.reserve(lanes);
+        free_.reserve(lanes);
+        for (std::size_t lane = lanes; lane-- > 0;) {
+            free_.push_back(lane);  // lowest lane is handed out first
+        }
+        stats_.lanes = lanes;
+        stats_.stateBytes = compact_ ? sizeof(CompactFlightState) : sizeof(FlightState);
+    }
+
+    std::size_t lanes() const { return courses_.size(); }
+    const BatchStats &stats() const { return stats_; }
+
+    // Zeroes the counters, keeping the lane layout, for per-run reporting.
+    void resetStats() {
+        const BatchStats layout = stats_;
+        stats_ = BatchStats{};
+        stats_.lanes = layout.lanes;
+        stats_.stateBytes = layout.stateBytes;
+    }
+
+    void enqueue(BatchEpisode episode) { pending_.push_back(std::move(episode)); }
+
+    // Runs until the pending queue is drained and every lane has retired.
+    void run(BatchDriver &driver) {
+        while (head_ < pending_.size() || !active_.empty()) {
+            refill(driver);
+            tick(driver);
+            if (head_ == pending_.size()) {
+                maybeCompact(driver);
+            }
+        }
+        pending_.clear();
+        head_ = 0;
+    }
+
+  private:
+    std::size_t maxSteps_;
+    double dt_;
+    bool compact_;
+
+    std::vector<FlightState> states_;
+    std::vector<CompactFlightState> packed_;
+    std::vector<std::shared_ptr<const Course>> courses_;
+    std::vector<std::shared_ptr<const Scenario>> scenarios_;
+    std::vector<ScenarioState> scenarioStates_;
+    std::vector<std::vector<std::uint64_t>> passed_;
+    std::vector<std::size_t> remaining_;
+    std::vector<std::size_t> steps_;
+    std::vector<std::uint32_t> tags_;
+
+    // A lane's timers carry the generation it had when they were scheduled;
+    // retiring or moving its episode changes the generation, so leftovers
+    // are dropped when they fire instead of being cancelled one by one.
+    struct LaneTimer {
+        std::size_t lane{0};
+        std::uint32_t generation{0};
+        std::uint32_t rule{0};
+    };
+    TimingWheel<LaneTimer> timers_;
+    std::uint64_t clock_{0};                // batch ticks run so far, the wheel's time base
+    std::vector<std::uint32_t> generations_;  // 0 while the lane is free
+    std::uint32_t nextGeneration_{0};
+    std::vector<std::uint64_t> due_;  // timed rules that fired this tick, per lane
+
+    std::vector<char> occupied_;  // compaction scratch
+    EventBuffer events_;          // one lane's events, reused lane by lane
+    std::vector<LaneView> views_;        // batched drivers: this tick's lanes,
+    std::vector<Input> inputs_;          // their commands
+    std::vector<FlightState> unpacked_;  // and unpacked compact states
+
+    std::vector<std::size_t> active_;
+    std::vector<std::size_t> free_;
+    std::vector<BatchEpisode> pending_;
+    std::size_t head_{0};
+    BatchStats stats_;
+
+    void refill(BatchDriver &driver) {
+        while (head_ < pending_.size() && !free_.empty()) {
+            const std::size_t lane = free_.back();
+            free_.pop_back();
+            BatchEpisode &episode = pending_[head_++];
+
+            const FlightState initial = episode.scenario ? episode.scenario->initialState() : FlightState{};
+            scenarioStates_[lane] = episode.scenario ? episode.scenario->initialScenarioState() : ScenarioState{};
+            scenarios_[lane] = std::move(episode.scenario);
+            if (compact_) {
+                packed_[lane] = CompactFlightState::pack(initial);
+            } else {
+                states_[lane] = initial;
+            }
+            courses_[lane] = std::move(episode.course);
+            passed_[lane].assign((courses_[lane]->size() + 63) / 64, 0);
+            remaining_[lane] = courses_[lane]->size();
+            steps_[lane] = 0;
+            tags_[lane] = episode.tag;
+            armTimers(lane);
+            active_.push_back(lane);
+            driver.started(lane, episode.tag, compact_ ? packed_[lane].unpack() : initial, *courses_[lane],
+                           passed_[lane].data());
+        }
+    }
+
+    // One pass per live lane: observe, act, step, then keep or retire it.
+    void tick(BatchDriver &driver) {
+        SIM_TRACE_SCOPE("batch.step");
+        SIM_PERF_SCOPE_TICKS(kBatchStep, active_.size());
+        ++stats_.ticks;
+        stats_.laneSteps += active_.size();
+        ++clock_;
+        fireTimers();
+
+        const bool batched = driver.batched();
+        if (batched) {
+            gatherInputs(driver);
+        }
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < active_.size(); ++i) {
+            const std::size_t lane = active_[i];
+            FlightState unpacked;
+            if (compact_) {
+                unpacked = batched ? unpacked_[i] : packed_[lane].unpack();
+            }
+            FlightState &state = compact_ ? unpacked : states_[lane];
+            const Course &course = *courses_[lane];
+            std::uint64_t *passed = passed_[lane].data();
+
+            ScenarioState &scenario = scenarioStates_[lane];
+            events_.clear();
+            const bool airborne = state.position.y > 0.0;
+            physics::applyInput(state,
+                                batched ? inputs_[i] : driver.act(lane, state, course, passed, remaining_[lane]));
+            physics::integrate(state, dt_, events_, scenario.wind);
+            physics::checkRings(state, course, passed, remaining_[lane], events_);
+            physics::clampToGround(state, events_, airborne);
+            rules::score(events_, state);
+            ++steps_[lane];
+            bool decided = false;
+            if (const Scenario *rules = scenarios_[lane].get()) {
+                const StepContext step{steps_[lane], dt_, remaining_[lane], course.size()};
+                decided = rules->run(scenario, state, step, events_, due_[lane]) != ScenarioOutcome::kRunning;
+                due_[lane] = 0;
+            }
+
+            const bool more = driver.stepped(lane, state, course, passed);
+            if (more && !decided && state.fuel > 0.0 && remaining_[lane] > 0 && steps_[lane] < maxSteps_) {
+                if (compact_) {
+                    packed_[lane] = CompactFlightState::pack(state);
+                }
+                active_[kept++] = lane;
+                continue;
+            }
+            driver.finished(lane, tags_[lane], state);
+            courses_[lane].reset();
+            scenarios_[lane].reset();
+            generations_[lane] = 0;
+            free_.push_back(lane);
+            ++stats_.episodes;
+        }
+        active_.resize(kept);
+    }
+
+    // One actAll() call for every live lane, before any of them is stepped.
+    void gatherInputs(BatchDriver &driver) {
+        for (std::size_t i = 0; i < active_.size(); ++i) {
+            const std::size_t lane = active_[i];
+            if (compact_) {
+                unpacked_[i] = packed_[lane].unpack();
+            }
+            const FlightState *state = compact_ ? &unpacked_[i] : &states_[lane];
+            views_[i] = {lane, state, courses_[lane].get(), passed_[lane].data(), remaining_[lane]};
+        }
+        driver.actAll(views_.data(), active_.size(), inputs_.data());
+    }
+
+    // Moves live lanes from the top of the range into holes below active_.size()
+    // once at least half of the occupied range is dead.
+    void maybeCompact(BatchDriver &driver) {
+        const std::size_t live = active_.size();
+        if (live == 0) {
+            return;
+        }
+        std::sort(active_.begin(), active_.end());
+        if (active_.back() < 2 * live) {
+            return;
+        }
+
+        std::fill(occupied_.begin(), occupied_.end(), 0);
+        for (const std::size_t lane : active_) {
+            occupied_[lane] = 1;
+        }
+        std::size_t hole = 0;
+        for (std::size_t i = live; i-- > 0 && active_[i] >= live;) {
+            while (occupied_[hole]) {
+                ++hole;
+            }
+            moveLane(active_[i], hole++, driver);
+        }
+        for (std::size_t lane = 0; lane < live; ++lane) {
+            active_[lane] = lane;
+        }
+        free_.clear();
+        for (std::size_t lane = lanes(); lane-- > live;) {
+            free_.push_back(lane);
+        }
+        ++stats_.compactions;
+    }
+
+    void moveLane(std::size_t from, std::size_t to, BatchDriver &driver) {
+        if (compact_) {
+            packed_[to] = packed_[from];
+        } else {
+            states_[to] = states_[from];
+        }
+        courses_[to] = std::move(courses_[from]);
+        scenarios_[to] = std::move(scenarios_[from]);
+        scenarioStates_[to] = scenarioStates_[from];
+        std::swap(passed_[to], passed_[from]);  // swap keeps both buffers' capacity
+        remaining_[to] = remaining_[from];
+        steps_[to] = steps_[from];
+        tags_[to] = tags_[from];
+        generations_[from] = 0;
+        armTimers(to);
+        driver.moved(from, to);
+    }
+
+    // Schedules the lane's timed rules from its current step under a new
+    // generation. The lane's next step runs on batch tick clock_ + 1.
+    void armTimers(std::size_t lane) {
+        if (++nextGeneration_ == 0) {
+            ++nextGeneration_;
+        }
+        generations_[lane] = nextGeneration_;
+        due_[lane] = 0;
+        const Scenario *rules = scenarios_[lane].get();
+        if (rules == nullptr) {
+            return;
+        }
+        for (std::size_t rule = 0; rule < rules->timedRules(); ++rule) {
+            if (const std::uint64_t ticks = rules->nextDue(rule, steps_[lane])) {
+                timers_.schedule(clock_ + ticks, {lane, nextGeneration_, static_cast<std::uint32_t>(rule)});
+            }
+        }
+    }
+
+    // Marks the timed rules due on this tick and reschedules `every` rules.
+    void fireTimers() {
+        timers_.advance(clock_, [this](std::uint64_t, const LaneTimer &timer) {
+            if (generations_[timer.lane] != timer.generation) {
+                return;
+            }
+            due_[timer.lane] |= std::uint64_t{1} << timer.rule;
+            const std::uint64_t step = steps_[timer.lane] + 1;  // the step this tick runs
+            if (const std::uint64_t ticks = scenarios_[timer.lane]->nextDue(timer.rule, step)) {
+                timers_.schedule(clock_ + ticks, timer);
+            }
+        });
+    }
+};
+
+}  // namespace sim
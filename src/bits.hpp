@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace sim {
+
+// Bit scans on 64-bit words, mapped to the compiler's intrinsic so they stay
+// one instruction on both GCC/Clang and MSVC.
+
+// Index of the lowest set bit; value must not be zero.
+inline unsigned lowestSetBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+// Number of set bits.
+inline unsigned popcount64(std::uint64_t value) {
+#if defined(_MSC_VER)
+    return static_cast<unsigned>(__popcnt64(value));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(value));
+#endif
+}
+
+}  // namespace sim
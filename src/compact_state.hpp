@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "simulator.hpp"
+
+namespace sim {
+
+// Quantised FlightState for very large populations: 28 bytes instead of 96.
+// Positions are 16-bit offsets inside a 1 km cell whose 8-bit index is kept
+// per axis: ±131 km across and up, and 0 to 262 km along the course, which
+// always runs toward +z from the start. Positions outside are clamped to the
+// edge, so callers check covers() before choosing compact storage for a
+// course. Velocities and angles are 16-bit fixed point, throttle is 8-bit and
+// fuel 16.16 fixed point. The batch stepper unpacks a lane into a FlightState
+// on the stack, runs the ordinary flight model and packs it back, so only the
+// compact form ever travels through memory.
+//
+// Per-field resolution: position 1.6 cm, velocity 1/32 m/s (±1024 m/s), angles
+// 0.0055 deg, throttle 1/255, fuel 1/65536 unit (at most 65536). Yaw is wrapped
+// to [-pi, pi). Fuel gets the extra bits because it changes by a tiny amount
+// every tick: even the lowest non-zero throttle burns about 6 steps per 0.1 s
+// tick, where a 1/256 step would round any burn below ~8% throttle away.
+struct CompactFlightState {
+    static constexpr double kCellSize = 1024.0;
+    static constexpr double kPositionStep = kCellSize / 65536.0;
+    static constexpr double kVelocityStep = 1.0 / 32.0;
+    static constexpr double kAngleStep = 2.0 * M_PI / 65536.0;
+    static constexpr double kThrottleStep = 1.0 / 255.0;
+    static constexpr double kFuelStep = 1.0 / 65536.0;
+    static constexpr double kMaxDepth = 256.0 * kCellSize;
+
+    // Whether every position an episode reaches on rings between depths
+    // shallowest and deepest is representable, allowing one ring spacing of
+    // overshoot past the last ring.
+    static bool covers(double shallowest, double deepest) {
+        return shallowest >= 0.0 && deepest + Course::kSpacing <= kMaxDepth;
+    }
+
+    std::uint32_t fuel{0};
+    std::array<std::uint16_t, 3> offset{};
+    std::array<std::int16_t, 3> velocity{};
+    std::int16_t yaw{0};
+    std::int16_t pitch{0};
+    std::int16_t roll{0};
+    std::uint16_t score{0};
+    std::array<std::int8_t, 2> cell{};  // x, y
+    std::uint8_t depthCell{0};          // z
+    std::uint8_t throttle{0};
+
+    static CompactFlightState pack(const FlightState &state) {
+        CompactFlightState out;
+        packAxis(state.position.x, out.cell[0], out.offset[0]);
+        packAxis(state.position.y, out.cell[1], out.offset[1]);
+        packAxis(state.position.z, out.depthCell, out.offset[2]);
+        out.velocity = {packVelocity(state.velocity.x), packVelocity(state.velocity.y),
+                        packVelocity(state.velocity.z)};
+        out.yaw = packAngle(state.yaw);
+        out.pitch = packAngle(state.pitch);
+        out.roll = packAngle(state.roll);
+        out.throttle = static_cast<std::uint8_t>(std::lround(std::clamp(state.throttle, 0.0, 1.0) / kThrottleStep));
+        out.fuel = static_cast<std::uint32_t>(std::llround(std::clamp(state.fuel / kFuelStep, 0.0, 4294967295.0)));
+        out.score = static_cast<std::uint16_t>(std::clamp(state.score, 0, 65535));
+        return out;
+    }
+
+    FlightState unpack() const {
+        FlightState state;
+        state.position = {unpackAxis(cell[0], offset[0]), unpackAxis(cell[1], offset[1]),
+                          unpackAxis(depthCell, offset[2])};
+        state.velocity = {velocity[0] * kVelocityStep, velocity[1] * kVelocityStep, velocity[2] * kVelocityStep};
+        state.yaw = yaw * kAngleStep;
+        state.pitch = pitch * kAngleStep;
+        state.roll = roll * kAngleStep;
+        state.throttle = throttle * kThrottleStep;
+        state.fuel = fuel * kFuelStep;
+        state.score = score;
+        return state;
+    }
+
+  private:
+    template <typename Cell>
+    static void packAxis(double value, Cell &cellIndex, std::uint16_t &offsetSteps) {
+        constexpr double kFirst = std::numeric_limits<Cell>::min();
+        constexpr double kLast = std::numeric_limits<Cell>::max();
+        double index = std::floor(value / kCellSize);
+        long steps = std::lround((value - index * kCellSize) / kPositionStep);
+        if (steps == 65536) {
+            index += 1.0;
+            steps = 0;
+        }
+        if (index < kFirst) {
+            index = kFirst;
+            steps = 0;
+        } else if (index > kLast) {
+            index = kLast;
+            steps = 65535;
+        }
+        cellIndex = static_cast<Cell>(index);
+        offsetSteps = static_cast<std::uint16_t>(steps);
+    }
+
+    template <typename Cell>
+    static double unpackAxis(Cell cellIndex, std::uint16_t offsetSteps) {
+        return cellIndex * kCellSize + offsetSteps * kPositionStep;
+    }
+
+    static std::int16_t packVelocity(double value) {
+        return static_cast<std::int16_t>(std::lround(std::clamp(value / kVelocityStep, -32768.0, 32767.0)));
+    }
+
+    // Wraps modulo 2*pi by keeping the low 16 bits of the step count.
+    static std::int16_t packAngle(double radians) {
+        const auto steps = static_cast<std::uint16_t>(std::llround(radians / kAngleStep) & 0xFFFF);
+        return static_cast<std::int16_t>(steps >= 32768 ? static_cast<int>(steps) - 65536 : steps);
+    }
+};
+
+static_assert(sizeof(CompactFlightState) == 28, "CompactFlightState must stay packed");
+
+}  // namespace sim
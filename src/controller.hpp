@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "simulator.hpp"
+
+namespace sim {
+
+// Largest per-tick command a controller may issue; matches one keypress of the
+// interactive console so learned policies cannot out-muscle a human pilot.
+constexpr double kMaxThrottleDelta = 0.04;
+constexpr double kMaxPitchDelta = 0.8 * kDegToRad;
+constexpr double kMaxYawDelta = 1.2 * kDegToRad;
+constexpr double kMaxRollDelta = 1.4 * kDegToRad;
+
+// Normalised features a controller sees each tick. The target ring is expressed
+// in the aircraft's heading frame so the same weights work anywhere on the course.
+struct Observation {
+    static constexpr std::size_t kSize = 10;
+    std::array<double, kSize> features{};
+};
+
+constexpr std::size_t kNoRing = static_cast<std::size_t>(-1);
+
+// Index of the first ring that is neither passed nor already behind the
+// aircraft, or kNoRing once the course is done.
+inline std::size_t nextRing(const FlightState &state, const Course &course, const std::uint64_t *passed) {
+    for (std::size_t i = course.firstAhead(state.position.z); i < course.size(); ++i) {
+        if (!physics::ringPassed(passed, i) && course.z()[i] + course.radius()[i] >= state.position.z) {
+            return i;
+        }
+    }
+    return kNoRing;
+}
+
+inline std::size_t nextRing(const Simulator &simulator) {
+    return nextRing(simulator.state(), simulator.course(), simulator.passedBits());
+}
+
+inline Observation observe(const FlightState &state, const Course &course, const std::uint64_t *passed) {
+    Observation obs;
+    auto &f = obs.features;
+
+    Vec3 toRing{0.0, 0.0, 0.0};
+    const std::size_t ring = nextRing(state, course, passed);
+    if (ring != kNoRing) {
+        toRing = rotateY(course.ring(ring).position - state.position, -state.yaw);
+    }
+
+    f[0] = std::clamp(toRing.x / 200.0, -2.0, 2.0);
+    f[1] = std::clamp(toRing.y / 100.0, -2.0, 2.0);
+    f[2] = std::clamp(toRing.z / 320.0, -2.0, 2.0);
+    f[3] = state.velocity.y / 30.0;
+    f[4] = length(state.velocity) / 60.0;
+    f[5] = state.pitch;
+    f[6] = state.roll;
+    f[7] = state.throttle;
+    f[8] = state.fuel / 120.0;
+    f[9] = state.position.y / 100.0;
+    return obs;
+}
+
+inline Observation observe(const Simulator &simulator) {
+    return observe(simulator.state(), simulator.course(), simulator.passedBits());
+}
+
+// Single-layer tanh policy: one weight row (plus bias) per Input channel.
+class LinearController {
+  public:
+    static constexpr std::size_t kOutputs = 4;
+    static constexpr std::size_t kParameterCount = kOutputs * (Observation::kSize + 1);
+
+    explicit LinearController(const double *params) : params_(params) {}
+
+    Input act(const Observation &obs) const {
+        std::array<double, kOutputs> out{};
+        for (std::size_t o = 0; o < kOutputs; ++o) {
+            const double *row = params_ + o * (Observation::kSize + 1);
+            double sum = row[Observation::kSize];
+            for (std::size_t i = 0; i < Observation::kSize; ++i) {
+                sum += row[i] * obs.features[i];
+            }
+            out[o] = std::tanh(sum);
+        }
+
+        Input input;
+        input.throttleDelta = out[0] * kMaxThrottleDelta;
+        input.pitchDelta = out[1] * kMaxPitchDelta;
+        input.yawDelta = out[2] * kMaxYawDelta;
+        input.rollDelta = out[3] * kMaxRollDelta;
+        return input;
+    }
+
+  private:
+    const double *params_;
+};
+
+}  // namespace sim
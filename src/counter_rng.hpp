@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace sim {
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Output is a pure function of (key, counter), so any worker can regenerate any
+// stream from a seed without sharing generator state.
+struct Philox4x32 {
+    using Counter = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    static Counter generate(Counter ctr, Key key) {
+        constexpr std::uint32_t kMul0 = 0xD2511F53u;
+        constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+        constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+        constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(kMul0) * ctr[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(kMul1) * ctr[2];
+            ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+                   static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+            key[0] += kWeyl0;
+            key[1] += kWeyl1;
+        }
+        return ctr;
+    }
+};
+
+// Sequential view over one Philox stream. The stream id occupies the upper half
+// of the counter and the draw index the lower half, so (seed, stream) pairs never
+// overlap for up to 2^64 blocks each.
+class CounterRng {
+  public:
+    CounterRng(std::uint64_t seed, std::uint64_t stream, std::uint64_t offset = 0)
+        : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          stream_(stream),
+          block_(offset) {}
+
+    std::uint32_t nextU32() {
+        if (lane_ == 4) {
+            refill();
+        }
+        return buffer_[lane_++];
+    }
+
+    // Uniform in [0, 1) with 53 bits of precision.
+    double uniform() {
+        const std::uint64_t hi = nextU32() >> 5;
+        const std::uint64_t lo = nextU32() >> 6;
+        return static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+    }
+
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+
+    // Standard normal via Box-Muller; the second variate is cached.
+    double normal() {
+        if (hasSpare_) {
+            hasSpare_ = false;
+            return spare_;
+        }
+        constexpr double kTwoPi = 6.283185307179586;
+        const double u1 = 1.0 - uniform();  // (0, 1], keeps log finite
+        const double u2 = uniform();
+        const double r = std::sqrt(-2.0 * std::log(u1));
+        spare_ = r * std::sin(kTwoPi * u2);
+        hasSpare_ = true;
+        return r * std::cos(kTwoPi * u2);
+    }
+
+  private:
+    Philox4x32::Key key_;
+    std::uint64_t stream_;
+    std::uint64_t block_;
+    Philox4x32::Counter buffer_{};
+    int lane_{4};
+    double spare_{0.0};
+    bool hasSpare_{false};
+
+    void refill() {
+        const Philox4x32::Counter ctr{static_cast<std::uint32_t>(block_), static_cast<std::uint32_t>(block_ >> 32),
+                                      static_cast<std::uint32_t>(stream_), static_cast<std::uint32_t>(stream_ >> 32)};
+        buffer_ = Philox4x32::generate(ctr, key_);
+        ++block_;
+        lane_ = 0;
+    }
+};
+
+}  // namespace sim
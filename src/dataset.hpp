@@ -0,0 +1,294 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "controller.hpp"
+#include "mapped_file.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+// On-disk layout of an imitation-learning dataset directory:
+//
+//   index.bin          DatasetIndexHeader, then one DatasetChunkEntry per chunk
+//   chunk-000000.bin   DatasetChunkHeader, then kDatasetColumns column arrays
+//
+// Every column is a contiguous array of 4-byte values starting on a 64-byte
+// boundary, so a mapped chunk can be handed to a training framework as-is.
+// Chunks are written whole and renamed into place before the index entry that
+// references them is appended, which keeps the directory valid after a crash.
+namespace dataset {
+
+constexpr std::uint32_t kIndexMagic = 0x49445346;  // "FSDI"
+constexpr std::uint32_t kChunkMagic = 0x43445346;  // "FSDC"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kAlignment = 64;
+
+// Column order: observation features, then Input channels, then the tick number.
+constexpr std::size_t kFeatureColumns = Observation::kSize;
+constexpr std::size_t kInputColumns = 4;
+constexpr std::size_t kTickColumn = kFeatureColumns + kInputColumns;
+constexpr std::size_t kColumns = kTickColumn + 1;
+
+struct IndexHeader {
+    std::uint32_t magic{kIndexMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t featureColumns{kFeatureColumns};
+    std::uint32_t inputColumns{kInputColumns};
+};
+
+struct ChunkEntry {
+    std::uint64_t firstSample{0};
+    std::uint32_t rows{0};
+    std::uint32_t chunkId{0};
+    std::uint32_t episode{0};
+    std::uint32_t reserved{0};
+};
+
+struct ChunkHeader {
+    std::uint32_t magic{kChunkMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t rows{0};
+    std::uint32_t columns{kColumns};
+    std::array<std::uint64_t, kColumns> columnOffsets{};
+};
+
+inline std::size_t alignUp(std::size_t value) { return (value + kAlignment - 1) & ~(kAlignment - 1); }
+
+inline std::string chunkFileName(std::uint32_t chunkId) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "chunk-%06u.bin", chunkId);
+    return name;
+}
+
+}  // namespace dataset
+
+// Buffers (observation, Input) pairs column-wise and appends them to a dataset
+// directory one chunk at a time. Each writer instance records one episode.
+class DatasetWriter {
+  public:
+    explicit DatasetWriter(const std::string &directory, std::size_t chunkRows = 65536)
+        : directory_(directory), chunkRows_(chunkRows) {
+        std::filesystem::create_directories(directory_);
+        loadIndex();
+        for (auto &column : columns_) {
+            column.reserve(chunkRows_);
+        }
+    }
+
+    ~DatasetWriter() { flush(); }
+
+    DatasetWriter(const DatasetWriter &) = delete;
+    DatasetWriter &operator=(const DatasetWriter &) = delete;
+
+    bool ok() const { return ok_; }
+    std::uint32_t episode() const { return episode_; }
+    std::uint64_t samplesWritten() const { return nextSample_ + columns_[0].size(); }
+
+    void append(const Observation &obs, const Input &input, std::uint32_t tick) {
+        for (std::size_t i = 0; i < dataset::kFeatureColumns; ++i) {
+            columns_[i].push_back(static_cast<float>(obs.features[i]));
+        }
+        columns_[dataset::kFeatureColumns + 0].push_back(static_cast<float>(input.throttleDelta));
+        columns_[dataset::kFeatureColumns + 1].push_back(static_cast<float>(input.pitchDelta));
+        columns_[dataset::kFeatureColumns + 2].push_back(static_cast<float>(input.yawDelta));
+        columns_[dataset::kFeatureColumns + 3].push_back(static_cast<float>(input.rollDelta));
+        float tickBits;
+        std::memcpy(&tickBits, &tick, sizeof(tickBits));
+        columns_[dataset::kTickColumn].push_back(tickBits);
+
+        if (columns_[0].size() >= chunkRows_) {
+            flush();
+        }
+    }
+
+    void flush() {
+        const std::size_t rows = columns_[0].size();
+        if (rows == 0 || !ok_) {
+            return;
+        }
+
+        dataset::ChunkHeader header;
+        header.rows = static_cast<std::uint32_t>(rows);
+        std::size_t offset = dataset::alignUp(sizeof(header));
+        for (std::size_t c = 0; c < dataset::kColumns; ++c) {
+            header.columnOffsets[c] = offset;
+            offset = dataset::alignUp(offset + rows * sizeof(float));
+        }
+
+        const std::filesystem::path finalPath = directory_ / dataset::chunkFileName(nextChunk_);
+        const std::filesystem::path tempPath = finalPath.string() + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            std::vector<char> image(offset, 0);
+            std::memcpy(image.data(), &header, sizeof(header));
+            for (std::size_t c = 0; c < dataset::kColumns; ++c) {
+                std::memcpy(image.data() + header.columnOffsets[c], columns_[c].data(), rows * sizeof(float));
+            }
+            out.write(image.data(), static_cast<std::streamsize>(image.size()));
+            ok_ = static_cast<bool>(out);
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempPath, finalPath, ec);
+        ok_ = ok_ && !ec;
+        if (!ok_) {
+            return;
+        }
+
+        dataset::ChunkEntry entry;
+        entry.firstSample = nextSample_;
+        entry.rows = header.rows;
+        entry.chunkId = nextChunk_;
+        entry.episode = episode_;
+        std::ofstream index(directory_ / "index.bin", std::ios::binary | std::ios::app);
+        index.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        ok_ = static_cast<bool>(index);
+
+        ++nextChunk_;
+        nextSample_ += rows;
+        for (auto &column : columns_) {
+            column.clear();
+        }
+    }
+
+  private:
+    std::filesystem::path directory_;
+    std::size_t chunkRows_;
+    std::array<std::vector<float>, dataset::kColumns> columns_;
+    std::uint32_t nextChunk_{0};
+    std::uint64_t nextSample_{0};
+    std::uint32_t episode_{0};
+    bool ok_{true};
+
+    // Resume numbering after whatever earlier sessions left in the directory.
+    void loadIndex() {
+        const std::filesystem::path indexPath = directory_ / "index.bin";
+        MappedFile index(indexPath.string());
+        if (index.size() < sizeof(dataset::IndexHeader)) {
+            std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+            const dataset::IndexHeader header;
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            ok_ = static_cast<bool>(out);
+            return;
+        }
+
+        dataset::IndexHeader header;
+        std::memcpy(&header, index.data(), sizeof(header));
+        if (header.magic != dataset::kIndexMagic || header.version != dataset::kVersion ||
+            header.featureColumns != dataset::kFeatureColumns) {
+            ok_ = false;
+            return;
+        }
+        const std::size_t entries = (index.size() - sizeof(header)) / sizeof(dataset::ChunkEntry);
+        for (std::size_t i = 0; i < entries; ++i) {
+            dataset::ChunkEntry entry;
+            std::memcpy(&entry, index.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+            nextChunk_ = std::max(nextChunk_, entry.chunkId + 1);
+            nextSample_ = std::max<std::uint64_t>(nextSample_, entry.firstSample + entry.rows);
+            episode_ = std::max(episode_, entry.episode + 1);
+        }
+
+        // A crash in the middle of an entry append leaves a partial entry;
+        // cut it off so the next append starts on an entry boundary.
+        const std::size_t complete = sizeof(header) + entries * sizeof(dataset::ChunkEntry);
+        if (index.size() != complete) {
+            index.close();
+            std::error_code ec;
+            std::filesystem::resize_file(indexPath, complete, ec);
+            ok_ = !ec;
+        }
+    }
+};
+
+// Zero-copy view of a dataset directory: every chunk stays memory-mapped and
+// column accessors return pointers straight into the mapping.
+class DatasetReader {
+  public:
+    struct Chunk {
+        dataset::ChunkEntry entry;
+        MappedFile file;
+    };
+
+    explicit DatasetReader(const std::string &directory) {
+        const std::filesystem::path root(directory);
+        MappedFile index((root / "index.bin").string());
+        if (index.size() < sizeof(dataset::IndexHeader)) {
+            return;
+        }
+        dataset::IndexHeader header;
+        std::memcpy(&header, index.data(), sizeof(header));
+        if (header.magic != dataset::kIndexMagic || header.version != dataset::kVersion) {
+            return;
+        }
+
+        const std::size_t entries = (index.size() - sizeof(header)) / sizeof(dataset::ChunkEntry);
+        chunks_.reserve(entries);
+        for (std::size_t i = 0; i < entries; ++i) {
+            Chunk chunk;
+            std::memcpy(&chunk.entry, index.data() + sizeof(header) + i * sizeof(dataset::ChunkEntry),
+                        sizeof(dataset::ChunkEntry));
+            if (!chunk.file.open((root / dataset::chunkFileName(chunk.entry.chunkId)).string()) ||
+                !chunkValid(chunk)) {
+                continue;
+            }
+            totalSamples_ += chunk.entry.rows;
+            chunks_.push_back(std::move(chunk));
+        }
+        valid_ = true;
+    }
+
+    bool valid() const { return valid_; }
+    std::size_t chunkCount() const { return chunks_.size(); }
+    std::uint64_t totalSamples() const { return totalSamples_; }
+    const dataset::ChunkEntry &entry(std::size_t chunk) const { return chunks_[chunk].entry; }
+
+    const float *feature(std::size_t chunk, std::size_t index) const { return column<float>(chunk, index); }
+    const float *input(std::size_t chunk, std::size_t channel) const {
+        return column<float>(chunk, dataset::kFeatureColumns + channel);
+    }
+    const std::uint32_t *ticks(std::size_t chunk) const { return column<std::uint32_t>(chunk, dataset::kTickColumn); }
+
+  private:
+    std::vector<Chunk> chunks_;
+    std::uint64_t totalSamples_{0};
+    bool valid_{false};
+
+    // A chunk is only kept if its header matches the index entry and every
+    // column lies inside the file, so column() can index it without checks.
+    static bool chunkValid(const Chunk &chunk) {
+        if (chunk.file.size() < sizeof(dataset::ChunkHeader)) {
+            return false;
+        }
+        dataset::ChunkHeader header;
+        std::memcpy(&header, chunk.file.data(), sizeof(header));
+        if (header.magic != dataset::kChunkMagic || header.version != dataset::kVersion ||
+            header.columns != dataset::kColumns || header.rows != chunk.entry.rows) {
+            return false;
+        }
+        const std::uint64_t columnBytes = std::uint64_t{header.rows} * sizeof(float);
+        for (const std::uint64_t offset : header.columnOffsets) {
+            if (offset < sizeof(header) || offset % dataset::kAlignment != 0 || offset > chunk.file.size() ||
+                columnBytes > chunk.file.size() - offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    const T *column(std::size_t chunk, std::size_t index) const {
+        const unsigned char *base = chunks_[chunk].file.data();
+        const auto *header = reinterpret_cast<const dataset::ChunkHeader *>(base);
+        return reinterpret_cast<const T *>(base + header->columnOffsets[index]);
+    }
+};
+
+}  // namespace sim
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "batch.hpp"
+#include "controller.hpp"
+#include "counter_rng.hpp"
+#include "job_system.hpp"
+#include "numa.hpp"
+#include "perf_counters.hpp"
+#include "scenario.hpp"
+#include "simulator.hpp"
+#include "trace.hpp"
+
+namespace sim {
+
+struct EsConfig {
+    std::size_t pairs{32};                // antithetic pairs per iteration (population = 2 * pairs)
+    std::size_t episodesPerCandidate{4};  // courses flown by every candidate
+    std::size_t stepsPerEpisode{600};
+    std::size_t ringCount{6};
+    double dt{0.1};
+    double sigma{0.1};
+    double learningRate{0.05};
+    std::uint64_t seed{1};
+    unsigned int threads{0};  // 0 = one per hardware thread
+    std::size_t batchLanes{64};  // aircraft stepped together by each worker
+    StateStorage storage{StateStorage::kFull};
+    bool pinThreads{false};  // pin pool threads across NUMA nodes
+    std::shared_ptr<const Scenario> scenario;  // optional: start state, wind, rules and course size
+};
+
+struct EsIterationStats {
+    std::size_t iteration{0};
+    double meanFitness{0.0};
+    double bestFitness{0.0};
+    double seconds{0.0};
+    double laneUtilization{0.0};  // share of batch lane slots that stepped a live aircraft
+};
+
+// OpenAI-style evolution strategies with antithetic sampling. Perturbations are
+// never materialised outside the worker that evaluates them: each one is a
+// Philox stream keyed by (seed, iteration, pair), so workers exchange only the
+// candidate index they pulled and the scalar fitness they produced, and the
+// update step regenerates the same noise from the same seeds.
+class EsTrainer {
+  public:
+    explicit EsTrainer(const EsConfig &config)
+        : config_(config), params_(LinearController::kParameterCount, 0.0) {}
+
+    const EsConfig &config() const { return config_; }
+    const std::vector<double> &parameters() const { return params_; }
+    void setParameters(const std::vector<double> &params) { params_ = params; }
+
+    EsIterationStats iterate() {
+        const auto start = std::chrono::steady_clock::now();
+        const std::size_t population = config_.pairs * 2;
+        std::vector<double> fitness(population, 0.0);
+        const std::vector<std::shared_ptr<const Course>> episodes = courses(iteration_);
+
+        // A block is at most one full batch of episodes, and smaller when the
+        // population does not give every thread that much; the batch is then
+        // sized to the block so that every lane starts with an episode.
+        JobSystem &jobs = jobSystem();
+        const std::size_t blockSize = std::max<std::size_t>(
+            1, std::min(config_.batchLanes / config_.episodesPerCandidate,
+                        (population + jobs.threadCount() - 1) / jobs.threadCount()));
+        const std::size_t blocks = (population + blockSize - 1) / blockSize;
+        const std::size_t lanes = std::min(config_.batchLanes, blockSize * config_.episodesPerCandidate);
+
+        // Each pool thread builds its batch on first use, after it was pinned, so
+        // first touch places the lane arrays on that thread's node. Workers
+        // persist across iterations, so that happens once per thread.
+        const numa::PinScope pin(pinSlots_.empty() ? -1 : pinSlots_[0].cpu);
+        jobs.parallelFor(0, blocks, 1, [&](std::size_t lo, std::size_t hi) {
+            BatchWorker &w =
+                workers_->get(jobs, [&] { return BatchWorker(config_, lanes, blockSize * params_.size()); });
+            for (std::size_t blockIndex = lo; blockIndex < hi; ++blockIndex) {
+                const std::size_t first = blockIndex * blockSize;
+                trace::Recorder::instance().beginTick(first);
+                SIM_TRACE_SCOPE("es.block");
+                const std::size_t count = std::min(blockSize, population - first);
+                for (std::size_t b = 0; b < count; ++b) {
+                    const std::size_t c = first + b;
+                    const double sign = (c % 2 == 0) ? 1.0 : -1.0;
+                    CounterRng noise = noiseStream(iteration_, c / 2);
+                    double *candidate = w.block.data() + b * params_.size();
+                    for (std::size_t j = 0; j < params_.size(); ++j) {
+                        candidate[j] = params_[j] + sign * config_.sigma * noise.normal();
+                    }
+                }
+                evaluate(w.block.data(), count, episodes, w.batch, w.scorer, fitness.data() + first);
+            }
+        });
+        std::uint64_t laneSteps = 0;
+        std::uint64_t laneSlots = 0;
+        workers_->forEach([&](BatchWorker &w) {
+            laneSteps += w.batch.stats().laneSteps;
+            laneSlots += w.batch.stats().ticks * w.batch.lanes();
+            w.batch.resetStats();
+        });
+
+        applyUpdate(fitness);
+
+        EsIterationStats stats;
+        stats.iteration = iteration_++;
+        stats.meanFitness = std::accumulate(fitness.begin(), fitness.end(), 0.0) / static_cast<double>(population);
+        stats.bestFitness = *std::max_element(fitness.begin(), fitness.end());
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.laneUtilization =
+            laneSlots > 0 ? static_cast<double>(laneSteps) / static_cast<double>(laneSlots) : 0.0;
+        return stats;
+    }
+
+    // Average fitness of the current (unperturbed) parameters on a fresh set of courses.
+    double evaluateCurrent() const {
+        BatchSimulator batch(config_.episodesPerCandidate, config_.stepsPerEpisode, config_.dt, config_.storage);
+        EpisodeScorer scorer(batch.lanes(), config_.episodesPerCandidate);
+        double fitness = 0.0;
+        evaluate(params_.data(), 1, courses(~iteration_), batch, scorer, &fitness);
+        return fitness;
+    }
+
+  private:
+    EsConfig config_;
+    std::vector<double> params_;
+    std::size_t iteration_{0};
+    std::vector<numa::WorkerSlot> pinSlots_;
+    std::unique_ptr<JobSystem> jobs_;  // created by the first iterate() on the calling thread
+
+    struct BatchWorker;
+    std::unique_ptr<WorkerLocal<BatchWorker>> workers_;  // one per pool thread, kept across iterations
+
+    JobSystem &jobSystem() {
+        if (!jobs_) {
+            const unsigned int threads =
+                config_.threads != 0 ? config_.threads : std::max(1u, std::thread::hardware_concurrency());
+            if (config_.pinThreads) {
+                pinSlots_ = numa::placeWorkers(numa::topology(), threads);
+            }
+            std::function<void(unsigned int)> pinPoolThread;
+            if (!pinSlots_.empty()) {
+                pinPoolThread = [this](unsigned int index) { numa::pinCurrentThread(pinSlots_[index].cpu); };
+            }
+            jobs_ = std::make_unique<JobSystem>(threads, std::move(pinPoolThread));
+            workers_ = std::make_unique<WorkerLocal<BatchWorker>>(*jobs_);
+        }
+        return *jobs_;
+    }
+
+    CounterRng noiseStream(std::size_t iteration, std::size_t pair) const {
+        return CounterRng(config_.seed, (static_cast<std::uint64_t>(iteration) << 32) | pair);
+    }
+
+    // Every candidate in an iteration flies the same courses (common random numbers),
+    // which keeps the fitness differences between antithetic pairs low-variance.
+    // The courses are generated once and shared read-only by all workers.
+    std::vector<std::shared_ptr<const Course>> courses(std::size_t iteration) const {
+        CounterRng rng(config_.seed, (std::uint64_t{1} << 63) | iteration);
+        std::vector<std::shared_ptr<const Course>> result(config_.episodesPerCandidate);
+        for (auto &course : result) {
+            const std::uint32_t seed = rng.nextU32();
+            course = config_.scenario ? config_.scenario->course(seed) : Course::generate(config_.ringCount, seed);
+        }
+        return result;
+    }
+
+    // Scores the episodes of a block of candidates as they run side by side in
+    // a batch. An episode's return is its ring score plus a dense shaping term
+    // for the closest approach to each ring that was targeted but missed, so
+    // early iterations get a gradient before any ring has been reached.
+    class EpisodeScorer : public BatchDriver {
+      public:
+        EpisodeScorer(std::size_t lanes, std::size_t episodesPerCandidate)
+            : episodesPerCandidate_(episodesPerCandidate), lanes_(lanes) {}
+
+        // Tags are candidate * episodesPerCandidate + episode within the block.
+        void load(const double *params, std::size_t candidates) {
+            controllers_.clear();
+            for (std::size_t c = 0; c < candidates; ++c) {
+                controllers_.emplace_back(params + c * LinearController::kParameterCount);
+            }
+            returns_.assign(candidates * episodesPerCandidate_, 0.0);
+        }
+
+        double episodeReturn(std::size_t candidate, std::size_t episode) const {
+            return returns_[candidate * episodesPerCandidate_ + episode];
+        }
+
+        void started(std::size_t lane, std::uint32_t tag, const FlightState &state, const Course &course,
+                     const std::uint64_t *passed) override {
+            Lane &l = lanes_[lane];
+            l.controller = tag / episodesPerCandidate_;
+            l.target = nextRing(state, course, passed);
+            l.closest = std::numeric_limits<double>::infinity();
+            l.shaping = 0.0;
+        }
+
+        Input act(std::size_t lane, const FlightState &state, const Course &course, const std::uint64_t *passed,
+                  std::size_t) override {
+            return controllers_[lanes_[lane].controller].act(observe(state, course, passed));
+        }
+
+        bool stepped(std::size_t lane, const FlightState &state, const Course &course,
+                     const std::uint64_t *passed) override {
+            Lane &l = lanes_[lane];
+            if (l.target == kNoRing) {
+                return false;
+            }
+            l.closest = std::min(l.closest, length(course.ring(l.target).position - state.position));
+            const std::size_t next = nextRing(state, course, passed);
+            if (next != l.target) {
+                l.shaping += physics::ringPassed(passed, l.target) ? 0.0 : approachBonus(l.closest);
+                l.target = next;
+                l.closest = std::numeric_limits<double>::infinity();
+            }
+            return true;
+        }
+
+        void finished(std::size_t lane, std::uint32_t tag, const FlightState &state) override {
+            Lane &l = lanes_[lane];
+            if (l.target != kNoRing) {
+                l.shaping += approachBonus(l.closest);
+            }
+            returns_[tag] = static_cast<double>(state.score) + l.shaping;
+        }
+
+        void moved(std::size_t from, std::size_t to) override { lanes_[to] = lanes_[from]; }
+
+      private:
+        struct Lane {
+            std::size_t controller{0};
+            std::size_t target{kNoRing};
+            double closest{0.0};
+            double shaping{0.0};
+        };
+
+        std::size_t episodesPerCandidate_;
+        std::vector<Lane> lanes_;
+        std::vector<LinearController> controllers_;
+        std::vector<double> returns_;
+
+        static double approachBonus(double distance) { return 50.0 * std::max(0.0, 1.0 - distance / 400.0); }
+    };
+
+    // Per-thread evaluation state, reused by every block the thread runs.
+    struct BatchWorker {
+        BatchWorker(const EsConfig &config, std::size_t lanes, std::size_t blockValues)
+            : batch(lanes, config.stepsPerEpisode, config.dt, config.storage),
+              scorer(batch.lanes(), config.episodesPerCandidate),
+              block(blockValues) {}
+
+        BatchSimulator batch;
+        EpisodeScorer scorer;
+        std::vector<double> block;
+    };
+
+    // Fitness of `candidates` parameter vectors laid out back to back: the mean
+    // return over the shared courses, summed in course order so results do not
+    // depend on the order in which the batch retires episodes.
+    void evaluate(const double *params, std::size_t candidates,
+                  const std::vector<std::shared_ptr<const Course>> &courses, BatchSimulator &batch,
+                  EpisodeScorer &scorer, double *fitness) const {
+        scorer.load(params, candidates);
+        for (std::size_t c = 0; c < candidates; ++c) {
+            for (std::size_t e = 0; e < courses.size(); ++e) {
+                batch.enqueue({courses[e], static_cast<std::uint32_t>(c * courses.size() + e), config_.scenario});
+            }
+        }
+        batch.run(scorer);
+        for (std::size_t c = 0; c < candidates; ++c) {
+            double total = 0.0;
+            for (std::size_t e = 0; e < courses.size(); ++e) {
+                total += scorer.episodeReturn(c, e);
+            }
+            fitness[c] = total / static_cast<double>(courses.size());
+        }
+    }
+
+    void applyUpdate(const std::vector<double> &fitness) {
+        const std::size_t population = fitness.size();
+
+        // Centred-rank shaping makes the update invariant to the fitness scale.
+        std::vector<std::size_t> order(population);
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return fitness[a] < fitness[b]; });
+        std::vector<double> utility(population);
+        for (std::size_t rank = 0; rank < population; ++rank) {
+            utility[order[rank]] = static_cast<double>(rank) / static_cast<double>(population - 1) - 0.5;
+        }
+
+        std::vector<double> gradient(params_.size(), 0.0);
+        for (std::size_t pair = 0; pair < config_.pairs; ++pair) {
+            const double weight = utility[2 * pair] - utility[2 * pair + 1];
+            CounterRng noise = noiseStream(iteration_, pair);
+            for (double &g : gradient) {
+                g += weight * noise.normal();
+            }
+        }
+
+        const double scale = config_.learningRate / (static_cast<double>(population) * config_.sigma);
+        for (std::size_t j = 0; j < params_.size(); ++j) {
+            params_[j] += scale * gradient[j];
+        }
+    }
+};
+
+}  // namespace sim
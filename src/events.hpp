@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sim {
+
+struct FlightState;
+
+// Typed events emitted by the step pipeline. The flight model only reports
+// what happened; game rules (scoring) and presentation (HUD, recorder, network)
+// react to the events instead of being wired into the physics.
+enum class EventType : std::uint8_t {
+    kRingPassed,     // id = index of the ring flown through
+    kFuelLow,        // value = fuel left when crossing kFuelLowThreshold
+    kFuelEmpty,      // value = 0; the engine has cut out
+    kGroundContact,  // value = vertical speed at impact (m/s, <= 0)
+    kTimer,          // id, value = tag and value given to Simulator::schedule
+    kScenario,       // id, value = tag and value of a scenario `emit`
+    kScenarioEnd,    // value = 1 if the scenario succeeded, 0 if it failed
+};
+
+inline const char *eventName(EventType type) {
+    switch (type) {
+        case EventType::kRingPassed:
+            return "ring_passed";
+        case EventType::kFuelLow:
+            return "fuel_low";
+        case EventType::kFuelEmpty:
+            return "fuel_empty";
+        case EventType::kGroundContact:
+            return "ground_contact";
+        case EventType::kTimer:
+            return "timer";
+        case EventType::kScenario:
+            return "scenario";
+        case EventType::kScenarioEnd:
+            return "scenario_end";
+    }
+    return "unknown";
+}
+
+struct Event {
+    EventType type{EventType::kRingPassed};
+    std::uint32_t id{0};
+    double value{0.0};
+};
+
+constexpr double kFuelLowThreshold = 24.0;  // 20% of a full tank
+
+// Fixed-capacity buffer filled during one tick and cleared before the next.
+// Pushing never allocates; events beyond the capacity are counted and dropped.
+class EventBuffer {
+  public:
+    static constexpr std::size_t kCapacity = 32;
+
+    void clear() {
+        count_ = 0;
+        dropped_ = 0;
+    }
+
+    bool push(const Event &event) {
+        if (count_ == kCapacity) {
+            ++dropped_;
+            return false;
+        }
+        events_[count_++] = event;
+        return true;
+    }
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    std::size_t dropped() const { return dropped_; }
+    const Event *begin() const { return events_.data(); }
+    const Event *end() const { return events_.data() + count_; }
+    const Event &operator[](std::size_t i) const { return events_[i]; }
+
+  private:
+    std::array<Event, kCapacity> events_{};
+    std::size_t count_{0};
+    std::size_t dropped_{0};
+};
+
+class EventSubscriber {
+  public:
+    virtual ~EventSubscriber() = default;
+
+    // Called once after a tick that produced at least one event, with every
+    // event of that tick in emission order and the state after the step.
+    virtual void onEvents(std::uint64_t tick, const EventBuffer &events, const FlightState &state) = 0;
+};
+
+// Subscribers are registered up front in a fixed table, so publishing is a
+// plain loop with no allocation. The bus does not own its subscribers.
+class EventBus {
+  public:
+    static constexpr std::size_t kMaxSubscribers = 8;
+
+    bool subscribe(EventSubscriber *subscriber) {
+        if (subscriber == nullptr || count_ == kMaxSubscribers) {
+            return false;
+        }
+        subscribers_[count_++] = subscriber;
+        return true;
+    }
+
+    void unsubscribe(EventSubscriber *subscriber) {
+        auto *end = subscribers_.data() + count_;
+        auto *it = std::find(subscribers_.data(), end, subscriber);
+        if (it != end) {
+            std::copy(it + 1, end, it);
+            --count_;
+        }
+    }
+
+    void publish(std::uint64_t tick, const EventBuffer &events, const FlightState &state) const {
+        if (events.empty()) {
+            return;
+        }
+        for (std::size_t i = 0; i < count_; ++i) {
+            subscribers_[i]->onEvents(tick, events, state);
+        }
+    }
+
+  private:
+    std::array<EventSubscriber *, kMaxSubscribers> subscribers_{};
+    std::size_t count_{0};
+};
+
+}  // namespace sim
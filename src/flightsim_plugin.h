@@ -0,0 +1,55 @@
+#ifndef FLIGHTSIM_PLUGIN_H
+#define FLIGHTSIM_PLUGIN_H
+
+/* Controller plugin ABI. A plugin is a shared object exporting, with C
+ * linkage:
+ *
+ *   uint32_t flightsim_plugin_abi(void);        returns FLIGHTSIM_PLUGIN_ABI
+ *   void flightsim_control(const FlightsimState *states,
+ *                          FlightsimInput *out, size_t n);
+ *   const char *flightsim_plugin_name(void);    optional
+ *
+ * flightsim_control is called once per tick for a whole batch of aircraft and
+ * writes one command per state. It must not keep the pointers past the call.
+ * Commands are clamped to the simulator's per-tick limits (see controller.hpp);
+ * non-finite values are treated as 0. This header is plain C so plugins can be
+ * written in any language with a C FFI. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLIGHTSIM_PLUGIN_ABI 1u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FlightsimState {
+    double position[3]; /* m; y is altitude, z runs along the course */
+    double velocity[3]; /* m/s */
+    double yaw;         /* rad */
+    double pitch;       /* rad; positive is nose-down */
+    double roll;        /* rad */
+    double throttle;    /* 0..1 */
+    double fuel;
+    double ring[4];     /* next ring x, y, z and radius; radius 0 once the course is done */
+    uint32_t id;        /* stable for the aircraft's episode */
+    uint32_t rings_left;
+} FlightsimState;
+
+typedef struct FlightsimInput {
+    double throttle_delta;
+    double pitch_delta; /* rad per tick */
+    double yaw_delta;
+    double roll_delta;
+} FlightsimInput;
+
+typedef uint32_t (*flightsim_plugin_abi_fn)(void);
+typedef void (*flightsim_control_fn)(const FlightsimState *states, FlightsimInput *out, size_t n);
+typedef const char *(*flightsim_plugin_name_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLIGHTSIM_PLUGIN_H */
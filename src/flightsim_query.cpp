@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "job_system.hpp"
+#include "query_engine.hpp"
+#include "telemetry_query.hpp"
+
+namespace {
+
+struct QueryOptions {
+    sim::QuerySpec spec;
+    std::vector<std::string> paths;
+    std::string cacheDirectory{".flightsim-cache"};
+    std::size_t limit{20};
+    unsigned int threads{0};
+};
+
+void printUsage() {
+    std::cerr << "사용법: flightsim_query [옵션] <파일|디렉터리>... [조건...]\n"
+              << "  조건 예: altitude<10 speed>60 fuel<=5 (--where 로도 지정 가능)\n"
+              << "  --group-by <열[:구간]>  예: score:100, x:250 (여러 번 지정 가능)\n"
+              << "  --agg <함수>            count | sum:열 | min:열 | max:열 | avg:열\n"
+              << "  --final                 각 기록의 마지막 틱만 조회·집계\n"
+              << "  --threads N             스캔 스레드 수 (0 = 전체 코어)\n"
+              << "  --cache <디렉터리>      파일별 부분 집계 캐시 위치, --no-cache 로 끔\n"
+              << "  --limit N               행 출력 모드의 최대 출력 행 수\n";
+}
+
+// Whole-string decimal count; rejects empty input and trailing characters.
+bool parseCount(const char *text, std::size_t &out) {
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    out = static_cast<std::size_t>(value);
+    return true;
+}
+
+bool parseArguments(int argc, char **argv, QueryOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        sim::Predicate predicate;
+        sim::GroupBy group;
+        sim::Aggregate aggregate;
+        std::size_t count = 0;
+
+        if (arg == "--where" && hasValue && sim::Predicate::parse(argv[++i], predicate)) {
+            options.spec.predicates.push_back(predicate);
+        } else if (arg == "--group-by" && hasValue && sim::GroupBy::parse(argv[++i], group)) {
+            options.spec.groupBy.push_back(group);
+        } else if (arg == "--agg" && hasValue && sim::Aggregate::parse(argv[++i], aggregate)) {
+            options.spec.aggregates.push_back(aggregate);
+        } else if (arg == "--final") {
+            options.spec.finalRowOnly = true;
+        } else if (arg == "--threads" && hasValue && parseCount(argv[++i], count)) {
+            options.threads = static_cast<unsigned int>(count);
+        } else if (arg == "--cache" && hasValue) {
+            options.cacheDirectory = argv[++i];
+        } else if (arg == "--no-cache") {
+            options.cacheDirectory.clear();
+        } else if (arg == "--limit" && hasValue && parseCount(argv[++i], count)) {
+            options.limit = count;
+        } else if (arg.rfind("--", 0) != 0 && sim::Predicate::parse(arg, predicate)) {
+            options.spec.predicates.push_back(predicate);
+        } else if (arg.rfind("--", 0) != 0 && std::filesystem::exists(arg)) {
+            options.paths.push_back(arg);
+        } else {
+            std::cerr << "[error] 잘못된 인자: " << arg << "\n";
+            return false;
+        }
+    }
+    return !options.paths.empty();
+}
+
+// Expands directories into the .fst recordings below them, in a stable order.
+std::vector<std::string> collectFiles(const std::vector<std::string> &paths) {
+    std::vector<std::string> files;
+    for (const std::string &path : paths) {
+        if (!std::filesystem::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".fst") {
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+int listRows(const QueryOptions &options, const std::vector<std::string> &files) {
+    using namespace sim::telemetry;
+    const int shown[] = {kTick, kPosX, kPosY, kPosZ, kSpeed, kFuel, kScore};
+    std::vector<double> scratch;
+    std::size_t printed = 0;
+    std::uint64_t totalRows = 0;
+    sim::ScanStats total;
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (const int column : shown) {
+        std::cout << std::setw(11) << kColumnNames[column];
+    }
+    std::cout << "\n";
+
+    for (const std::string &file : files) {
+        const sim::TelemetryReader reader(file);
+        if (!reader.valid()) {
+            std::cerr << "[warn] 텔레메트리 파일이 아닙니다: " << file << "\n";
+            continue;
+        }
+        const bool finalOnly = options.spec.finalRowOnly;
+        totalRows += finalOnly ? std::min<std::uint64_t>(reader.rows(), 1) : reader.rows();
+        const sim::ScanStats stats = sim::scanTelemetry(
+            reader, options.spec.predicates, finalOnly, [&](const ChunkHeader &chunk, std::size_t row) {
+                if (printed++ >= options.limit) {
+                    return;
+                }
+                for (const int column : shown) {
+                    std::cout << std::setw(11) << sim::TelemetryReader::column(chunk, column, scratch)[row];
+                }
+                std::cout << "\n";
+            });
+        total.rowsMatched += stats.rowsMatched;
+        total.chunksScanned += stats.chunksScanned;
+        total.chunksSkipped += stats.chunksSkipped;
+    }
+
+    std::cout << "일치 " << total.rowsMatched << " / " << totalRows << " 행, 청크 스캔 " << total.chunksScanned
+              << ", 건너뜀 " << total.chunksSkipped << "\n";
+    return 0;
+}
+
+int aggregate(const QueryOptions &options, const std::vector<std::string> &files) {
+    const sim::QuerySpec &spec = options.spec;
+    const sim::QueryCache cache(options.cacheDirectory);
+
+    // Files with a valid cache entry are answered without touching their data;
+    // the rest are split into (file, chunk) work items for the scan threads.
+    struct WorkItem {
+        std::size_t file;
+        const sim::telemetry::ChunkHeader *chunk;
+        bool lastRowOnly;
+    };
+    std::vector<sim::PartialResult> perFile(files.size());
+    std::vector<std::unique_ptr<sim::TelemetryReader>> readers(files.size());
+    std::vector<WorkItem> work;
+    std::size_t cachedFiles = 0;
+
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        if (cache.load(spec, files[f], perFile[f])) {
+            ++cachedFiles;
+            continue;
+        }
+        perFile[f] = sim::PartialResult{};
+        readers[f] = std::make_unique<sim::TelemetryReader>(files[f]);
+        const auto &chunks = readers[f]->chunks();
+        if (!readers[f]->valid() || chunks.empty()) {
+            continue;
+        }
+        if (spec.finalRowOnly) {
+            work.push_back({f, chunks.back(), true});
+            continue;
+        }
+        for (const auto *chunk : chunks) {
+            work.push_back({f, chunk, false});
+        }
+    }
+
+    std::vector<sim::PartialResult> partials(work.size());
+    unsigned int threadCount = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+    threadCount = static_cast<unsigned int>(std::clamp<std::size_t>(threadCount, 1, std::max<std::size_t>(1, work.size())));
+    sim::JobSystem jobs(threadCount);
+    jobs.parallelFor(0, work.size(), 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            partials[i] = sim::aggregateChunk(spec, *work[i].chunk, work[i].lastRowOnly);
+        }
+    });
+
+    for (std::size_t i = 0; i < work.size(); ++i) {
+        perFile[work[i].file].merge(partials[i]);
+    }
+    sim::PartialResult total;
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        if (readers[f] && readers[f]->valid()) {
+            cache.store(spec, files[f], perFile[f]);
+        }
+        total.merge(perFile[f]);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (const sim::GroupBy &g : spec.groupBy) {
+        std::cout << std::setw(12) << sim::telemetry::kColumnNames[g.column];
+    }
+    for (const sim::Aggregate &a : spec.aggregates) {
+        std::cout << std::setw(14) << a.label();
+    }
+    std::cout << "\n";
+    for (const auto &[key, state] : total.groups) {
+        for (std::size_t g = 0; g < key.size(); ++g) {
+            std::cout << std::setw(12) << static_cast<double>(key[g]) * spec.groupBy[g].bucket;
+        }
+        for (std::size_t a = 0; a < spec.aggregates.size(); ++a) {
+            std::cout << std::setw(14) << state.value(spec.aggregates[a], a);
+        }
+        std::cout << "\n";
+    }
+    std::cout << "파일 " << files.size() << " (캐시 " << cachedFiles << "), 청크 스캔 " << total.chunksScanned
+              << ", 건너뜀 " << total.chunksSkipped << ", 스레드 " << threadCount << "\n";
+    return 0;
+}
+
+}  // namespace
+
+// Usage: flightsim_query [options] <file|dir>... [predicate...]
+// Without --agg/--group-by matching rows are listed; otherwise grouped
+// aggregates are computed across every recording in parallel.
+int main(int argc, char **argv) {
+    QueryOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    const std::vector<std::string> files = collectFiles(options.paths);
+    if (options.spec.aggregates.empty() && options.spec.groupBy.empty()) {
+        return listRows(options, files);
+    }
+    if (options.spec.aggregates.empty()) {
+        sim::Aggregate count;
+        sim::Aggregate::parse("count", count);
+        options.spec.aggregates.push_back(count);
+    }
+    return aggregate(options, files);
+}
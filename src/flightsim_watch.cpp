@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "shm_ring.hpp"
+
+namespace {
+
+struct WatchOptions {
+    std::string name{sim::shm::kDefaultName};
+    std::size_t every{1};
+    bool latest{false};
+    bool fromOldest{false};
+    double waitSeconds{0.0};
+};
+
+void printUsage() {
+    std::cerr << "사용법: flightsim_watch [옵션] [이름]\n"
+              << "  flightsim --shm <이름> 이 공유 메모리에 발행하는 비행 상태를 읽습니다 (기본 이름 "
+              << sim::shm::kDefaultName << ")\n"
+              << "  --latest      가장 최근 상태 하나만 출력하고 종료\n"
+              << "  --oldest      링에 남아 있는 가장 오래된 기록부터 읽기 (기본: 최신부터)\n"
+              << "  --every N     N개 기록마다 한 줄 출력\n"
+              << "  --wait S      발행자가 나타날 때까지 최대 S초 기다림\n";
+}
+
+bool parseArguments(int argc, char **argv, WatchOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--latest") {
+            options.latest = true;
+        } else if (arg == "--oldest") {
+            options.fromOldest = true;
+        } else if (arg == "--every" && hasValue) {
+            options.every = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+            if (options.every == 0) {
+                return false;
+            }
+        } else if (arg == "--wait" && hasValue) {
+            options.waitSeconds = std::strtod(argv[++i], nullptr);
+        } else if (!arg.empty() && arg.rfind("--", 0) != 0) {
+            options.name = arg.front() == '/' ? arg : "/" + arg;
+        } else {
+            std::cerr << "[error] 잘못된 인자: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void printHeader() {
+    std::cout << std::setw(10) << "tick" << std::setw(11) << "x" << std::setw(11) << "y" << std::setw(11) << "z"
+              << std::setw(11) << "speed" << std::setw(11) << "fuel" << std::setw(8) << "score" << std::setw(7)
+              << "rings" << "\n";
+}
+
+void printRecord(const sim::shm::Record &record) {
+    const double speed = std::sqrt(record.velocity.x * record.velocity.x + record.velocity.y * record.velocity.y +
+                                   record.velocity.z * record.velocity.z);
+    std::cout << std::fixed << std::setprecision(2) << std::setw(10) << record.tick << std::setw(11)
+              << record.position.x << std::setw(11) << record.position.y << std::setw(11) << record.position.z
+              << std::setw(11) << speed << std::setw(11) << record.fuel << std::setw(8) << record.score
+              << std::setw(7) << record.ringsLeft << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    WatchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.waitSeconds);
+    std::unique_ptr<sim::ShmReader> reader = std::make_unique<sim::ShmReader>(options.name);
+    while (!reader->ok() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        reader = std::make_unique<sim::ShmReader>(options.name);
+    }
+    if (!reader->ok()) {
+        std::cerr << "[error] 공유 메모리를 열 수 없습니다: " << options.name
+                  << " (flightsim --shm " << options.name << " 으로 실행 중인지 확인하세요)\n";
+        return 1;
+    }
+
+    if (!options.fromOldest) {
+        reader->seekLatest();
+    }
+    printHeader();
+    sim::shm::Record record;
+    std::uint64_t read = 0;
+    while (true) {
+        const sim::ShmReader::Status status = reader->next(record);
+        if (status == sim::ShmReader::Status::kClosed) {
+            break;
+        }
+        if (status == sim::ShmReader::Status::kPending) {
+            if (options.latest) {
+                std::cerr << "[error] 아직 발행된 기록이 없습니다\n";
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (read++ % options.every == 0) {
+            printRecord(record);
+            std::cout << std::flush;
+        }
+        if (options.latest) {
+            return 0;
+        }
+    }
+    std::cout << "발행자 종료: 기록 " << read << "개 읽음, " << reader->lost() << "개 놓침\n";
+    return 0;
+}
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sim {
+
+// Small work-stealing scheduler shared by the trainer, the batch benchmark and
+// the query tool. Every worker owns a fixed-size Chase-Lev deque: it pushes and
+// pops at the bottom, idle workers steal from the top. Jobs are fixed-size
+// records carved from a per-worker ring with the callable stored inline, so
+// spawning is a placement-new plus one deque push and never touches the heap.
+// When the ring slot or the deque is full the job simply runs inline.
+//
+// The thread that constructs the JobSystem takes part as worker 0 while it
+// waits; other foreign threads may call spawn/parallelFor but their jobs run
+// inline. Jobs must not throw.
+class JobSystem {
+  public:
+    // Jobs spawned against a group are joined by wait(group).
+    class TaskGroup {
+      public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+      private:
+        friend class JobSystem;
+        std::atomic<std::size_t> pending_{0};
+    };
+
+    // onThreadStart runs first on each pool thread (index 1..threads-1), e.g. to
+    // pin it before it allocates anything.
+    explicit JobSystem(unsigned int threads = 0, std::function<void(unsigned int)> onThreadStart = {})
+        : onThreadStart_(std::move(onThreadStart)) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        workers_.reserve(threads);
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>(this, i));
+        }
+        previous_ = current();
+        current() = workers_[0].get();
+        threads_.reserve(threads - 1);
+        for (unsigned int i = 1; i < threads; ++i) {
+            threads_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~JobSystem() {
+        stop_.store(true);
+        epoch_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+        sleepCv_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+        if (current() == workers_[0].get()) {
+            current() = previous_;
+        }
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers_.size()); }
+
+    // Index of the calling pool thread in [0, threadCount()), or -1 for a thread
+    // that does not belong to this system.
+    int workerIndex() const {
+        const Worker *self = current();
+        return self != nullptr && self->system == this ? static_cast<int>(self->index) : -1;
+    }
+
+    template <typename F>
+    void spawn(TaskGroup &group, F &&fn) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= Job::kPayloadBytes && alignof(Fn) <= alignof(std::max_align_t),
+                      "job capture too large; capture by reference");
+        Worker *self = current();
+        Job *job = self != nullptr && self->system == this ? self->allocate() : nullptr;
+        if (job == nullptr) {
+            fn();
+            return;
+        }
+        new (job->payload) Fn(std::forward<F>(fn));
+        job->run = [](Job &j) {
+            Fn *callable = std::launder(reinterpret_cast<Fn *>(j.payload));
+            (*callable)();
+            callable->~Fn();
+        };
+        job->group = &group;
+        group.pending_.fetch_add(1, std::memory_order_relaxed);
+        if (!self->deque.push(job)) {
+            execute(job);
+            return;
+        }
+        wakeOne();
+    }
+
+    // Helps run jobs until every job spawned against the group has finished.
+    void wait(TaskGroup &group) {
+        Worker *self = current();
+        const bool member = self != nullptr && self->system == this;
+        while (group.pending_.load(std::memory_order_acquire) > 0) {
+            Job *job = member ? findJob(*self) : nullptr;
+            if (job != nullptr) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Calls body(lo, hi) over disjoint subranges of [begin, end) no longer than
+    // grain, splitting recursively so idle workers steal the largest halves.
+    template <typename F>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, const F &body) {
+        if (begin >= end) {
+            return;
+        }
+        TaskGroup group;
+        split(group, begin, end, std::max<std::size_t>(1, grain), body);
+        wait(group);
+    }
+
+  private:
+    struct Job {
+        static constexpr std::size_t kPayloadBytes = 64;
+
+        void (*run)(Job &){nullptr};
+        TaskGroup *group{nullptr};
+        std::atomic<bool> busy{false};
+        alignas(std::max_align_t) unsigned char payload[kPayloadBytes];
+    };
+
+    // Chase-Lev deque over a fixed ring (Lê et al., "Correct and Efficient
+    // Work-Stealing for Weak Memory Models", 2013). push/pop are owner-only.
+    class WorkDeque {
+      public:
+        static constexpr std::int64_t kCapacity = 1024;
+
+        bool push(Job *job) {
+            const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+            const std::int64_t t = top_.load(std::memory_order_acquire);
+            if (b - t >= kCapacity) {
+                return false;
+            }
+            slots_[static_cast<std::size_t>(b & (kCapacity - 1))].store(job, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        Job *pop() {
+            const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = top_.load(std::memory_order_relaxed);
+            if (t > b) {
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Job *job = slots_[static_cast<std::size_t>(b & (kCapacity - 1))].load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last job: race the thieves for it.
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    job = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        Job *steal() {
+            std::int64_t t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t b = bottom_.load(std::memory_order_acquire);
+            if (t >= b) {
+                return nullptr;
+            }
+            Job *job = slots_[static_cast<std::size_t>(t & (kCapacity - 1))].load(std::memory_order_relaxed);
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return job;
+        }
+
+      private:
+        alignas(64) std::atomic<std::int64_t> top_{0};
+        alignas(64) std::atomic<std::int64_t> bottom_{0};
+        std::array<std::atomic<Job *>, kCapacity> slots_{};
+    };
+
+    struct alignas(64) Worker {
+        static constexpr std::size_t kJobRing = 1024;
+
+        Worker(JobSystem *owner, unsigned int workerIndex)
+            : system(owner), index(workerIndex), rng(0x9E3779B97F4A7C15ull * (workerIndex + 1)) {}
+
+        // A slot still held by a running or stolen job is not reused; the
+        // caller runs the job inline instead.
+        Job *allocate() {
+            Job &job = jobs[next & (kJobRing - 1)];
+            if (job.busy.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            job.busy.store(true, std::memory_order_relaxed);
+            ++next;
+            return &job;
+        }
+
+        JobSystem *system;
+        unsigned int index;
+        std::uint64_t rng;
+        std::size_t next{0};
+        WorkDeque deque;
+        std::array<Job, kJobRing> jobs{};
+    };
+
+    std::function<void(unsigned int)> onThreadStart_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Worker *previous_{nullptr};  // the owner thread's membership before this system
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_{false};
+    std::atomic<std::uint64_t> epoch_{0};  // bumped on every push so sleepers never miss work
+    std::atomic<unsigned int> sleepers_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCv_;
+
+    static Worker *&current() {
+        thread_local Worker *worker = nullptr;
+        return worker;
+    }
+
+    template <typename F>
+    void split(TaskGroup &group, std::size_t begin, std::size_t end, std::size_t grain, const F &body) {
+        while (end - begin > grain) {
+            const std::size_t mid = begin + (end - begin) / 2;
+            spawn(group, [this, &group, mid, end, grain, &body] { split(group, mid, end, grain, body); });
+            end = mid;
+        }
+        body(begin, end);
+    }
+
+    static void execute(Job *job) {
+        TaskGroup *group = job->group;
+        job->run(*job);
+        job->busy.store(false, std::memory_order_release);
+        group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    Job *findJob(Worker &self) {
+        if (Job *job = self.deque.pop()) {
+            return job;
+        }
+        const std::size_t count = workers_.size();
+        self.rng ^= self.rng << 13;
+        self.rng ^= self.rng >> 7;
+        self.rng ^= self.rng << 17;
+        const std::size_t start = static_cast<std::size_t>(self.rng % count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Worker &victim = *workers_[(start + i) % count];
+            if (&victim == &self) {
+                continue;
+            }
+            if (Job *job = victim.deque.steal()) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void wakeOne() {
+        epoch_.fetch_add(1);
+        if (sleepers_.load() > 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex_); }
+            sleepCv_.notify_one();
+        }
+    }
+
+    void workerLoop(unsigned int index) {
+        Worker &self = *workers_[index];
+        current() = &self;
+        if (onThreadStart_) {
+            onThreadStart_(index);
+        }
+        constexpr int kSpinsBeforeSleep = 64;
+        int idle = 0;
+        while (!stop_.load(std::memory_order_relaxed)) {
+            const std::uint64_t epoch = epoch_.load();
+            if (Job *job = findJob(self)) {
+                execute(job);
+                idle = 0;
+                continue;
+            }
+            if (++idle < kSpinsBeforeSleep) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            sleepers_.fetch_add(1);
+            sleepCv_.wait(lock, [&] { return epoch_.load() != epoch || stop_.load(); });
+            sleepers_.fetch_sub(1);
+            idle = 0;
+        }
+        current() = nullptr;
+    }
+};
+
+// One lazily built T per worker thread, constructed on the thread that first
+// uses it so its memory is first-touched where it is used. Threads outside the
+// system share worker 0's slot, so only use it from jobs and the owner thread.
+template <typename T>
+class WorkerLocal {
+  public:
+    explicit WorkerLocal(const JobSystem &jobs) : slots_(jobs.threadCount()) {}
+
+    template <typename Factory>
+    T &get(const JobSystem &jobs, Factory &&make) {
+        const int index = jobs.workerIndex();
+        std::unique_ptr<T> &slot = slots_[index >= 0 ? static_cast<std::size_t>(index) : 0];
+        if (!slot) {
+            slot = std::make_unique<T>(make());
+        }
+        return *slot;
+    }
+
+    template <typename F>
+    void forEach(F &&fn) {
+        for (auto &slot : slots_) {
+            if (slot) {
+                fn(*slot);
+            }
+        }
+    }
+
+  private:
+    std::vector<std::unique_ptr<T>> slots_;
+};
+
+}  // namespace sim
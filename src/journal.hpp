@@ -0,0 +1,422 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+#include "scenario.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+// On-disk layout of a session journal:
+//
+//   FileHeader                   what rebuilds the session: course seed, scenario, time limit
+//   { RecordHeader, payload }*   one input per tick, a checkpoint every few seconds
+//
+// Records are only ever appended. Each carries a CRC-32 over its header and
+// payload, so after a crash the reader keeps the longest prefix that checks
+// out and drops the torn tail.
+namespace journal {
+
+constexpr std::uint32_t kMagic = 0x4c4a5346;  // "FSJL"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kMaxScenarioPath = 255;
+
+enum RecordType : std::uint32_t { kInput = 1, kCheckpoint = 2 };
+
+static_assert(std::is_trivially_copyable_v<Input> && std::is_trivially_copyable_v<FlightState> &&
+                  std::is_trivially_copyable_v<ScenarioState>,
+              "journal records store simulator state as raw bytes");
+
+struct FileHeader {
+    std::uint32_t magic{kMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t seed{0};
+    std::uint32_t ringCount{0};
+    double timeLimitSeconds{0.0};
+    char scenarioPath[kMaxScenarioPath + 1]{};
+};
+
+struct RecordHeader {
+    std::uint32_t type{0};
+    std::uint32_t size{0};  // payload bytes
+    std::uint64_t tick{0};  // input: the tick it is applied on; checkpoint: completed ticks
+    std::uint32_t checksum{0};
+    std::uint32_t reserved{0};
+};
+
+// Followed by passedWords ring-bit words.
+struct Checkpoint {
+    FlightState state{};
+    Vec3 wind{0.0, 0.0, 0.0};
+    ScenarioState scenario{};
+    std::uint64_t tick{0};
+    std::uint32_t passedWords{0};
+    std::uint32_t reserved{0};
+};
+
+struct Session {
+    std::uint32_t seed{0};
+    std::uint32_t ringCount{0};
+    double timeLimitSeconds{0.0};
+    std::string scenarioPath;
+};
+
+inline std::uint32_t crc32(const void *data, std::size_t size, std::uint32_t crc = 0) {
+    static constexpr auto kTable = [] {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1u) != 0 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = kTable[(crc ^ bytes[i]) & 0xffu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline std::uint32_t checksum(RecordHeader header, const void *payload) {
+    header.checksum = 0;
+    return crc32(payload, header.size, crc32(&header, sizeof(header)));
+}
+
+// What a journal holds after a crash: the session, the newest checkpoint
+// (if any was committed) and the inputs flown after it.
+struct Recovery {
+    Session session;
+    bool haveCheckpoint{false};
+    Checkpoint checkpoint;
+    std::vector<std::uint64_t> passed;
+    std::vector<Input> tail;       // consecutive inputs from firstTailTick on
+    std::uint64_t firstTailTick{0};
+    std::uint64_t validBytes{0};   // length of the prefix that checked out
+    std::uint64_t droppedBytes{0};  // torn or corrupt tail
+};
+
+inline bool recover(const std::string &path, Recovery &out, std::string &error) {
+    out = Recovery{};
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(FileHeader)) {
+        error = "저널 파일을 읽을 수 없습니다: " + path;
+        return false;
+    }
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        error = "저널 파일 형식이 올바르지 않습니다: " + path;
+        return false;
+    }
+    header.scenarioPath[kMaxScenarioPath] = '\0';
+    out.session = {header.seed, header.ringCount, header.timeLimitSeconds, header.scenarioPath};
+
+    const unsigned char *data = file.data();
+    std::size_t at = sizeof(header);
+    std::uint64_t nextTick = 0;
+    while (file.size() - at >= sizeof(RecordHeader)) {
+        RecordHeader record;
+        std::memcpy(&record, data + at, sizeof(record));
+        const std::size_t payloadAt = at + sizeof(record);
+        if (record.size > file.size() - payloadAt || record.checksum != checksum(record, data + payloadAt)) {
+            break;
+        }
+        const unsigned char *payload = data + payloadAt;
+        if (record.type == kInput && record.size == sizeof(Input) && record.tick == nextTick) {
+            Input &input = out.tail.emplace_back();
+            std::memcpy(&input, payload, sizeof(input));
+            ++nextTick;
+        } else if (record.type == kCheckpoint && record.size >= sizeof(Checkpoint)) {
+            Checkpoint checkpoint;
+            std::memcpy(&checkpoint, payload, sizeof(checkpoint));
+            const std::size_t words = checkpoint.passedWords;
+            if (record.size != sizeof(checkpoint) + words * sizeof(std::uint64_t) || checkpoint.tick != nextTick) {
+                break;
+            }
+            out.haveCheckpoint = true;
+            out.checkpoint = checkpoint;
+            out.passed.resize(words);
+            std::memcpy(out.passed.data(), payload + sizeof(checkpoint), words * sizeof(std::uint64_t));
+            out.tail.clear();
+            out.firstTailTick = checkpoint.tick;
+        } else {
+            break;
+        }
+        at = payloadAt + record.size;
+    }
+    out.validBytes = at;
+    out.droppedBytes = file.size() - at;
+    return true;
+}
+
+}  // namespace journal
+
+struct JournalStats {
+    std::uint64_t records{0};
+    std::uint64_t bytes{0};
+    std::uint64_t commits{0};  // write + fdatasync pairs
+    std::chrono::microseconds maxCommitDelay{0};  // oldest record's wait until it was durable
+};
+
+// Appends journal records from the console thread and makes them durable on a
+// background thread. Records gather in memory until kGroupBytes are pending or
+// the oldest has waited maxDelay; then the writer commits the whole group with
+// one write and one fdatasync. A tick only pays for a small copy under a lock
+// the writer holds just long enough to swap buffers, and a crash loses at most
+// the last maxDelay (plus one fsync) of flying.
+class JournalWriter {
+  public:
+    static constexpr std::size_t kGroupBytes = 64 * 1024;
+
+    // Starts a new journal, replacing any file at `path`.
+    JournalWriter(const std::string &path, const journal::Session &session,
+                  std::chrono::milliseconds maxDelay = std::chrono::milliseconds(20))
+        : maxDelay_(maxDelay) {
+        journal::FileHeader header;
+        header.seed = session.seed;
+        header.ringCount = session.ringCount;
+        header.timeLimitSeconds = session.timeLimitSeconds;
+        std::memcpy(header.scenarioPath, session.scenarioPath.data(),
+                    std::min(session.scenarioPath.size(), journal::kMaxScenarioPath));
+        if (session.scenarioPath.size() > journal::kMaxScenarioPath || !openFile(path, true)) {
+            return;
+        }
+        ok_ = writeAll(&header, sizeof(header)) && sync();
+        start();
+    }
+
+    // Continues a recovered journal: drops everything after its valid prefix
+    // and appends from there.
+    JournalWriter(const std::string &path, std::uint64_t validBytes,
+                  std::chrono::milliseconds maxDelay = std::chrono::milliseconds(20))
+        : maxDelay_(maxDelay) {
+        if (!openFile(path, false)) {
+            return;
+        }
+#if defined(_WIN32)
+        ok_ = _chsize_s(fd_, static_cast<long long>(validBytes)) == 0 &&
+              _lseeki64(fd_, static_cast<long long>(validBytes), SEEK_SET) >= 0;
+#else
+        ok_ = ::ftruncate(fd_, static_cast<off_t>(validBytes)) == 0 &&
+              ::lseek(fd_, static_cast<off_t>(validBytes), SEEK_SET) >= 0 && sync();
+#endif
+        start();
+    }
+
+    JournalWriter(const JournalWriter &) = delete;
+    JournalWriter &operator=(const JournalWriter &) = delete;
+
+    ~JournalWriter() {
+        if (writer_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_one();
+            writer_.join();
+        }
+        if (fd_ >= 0) {
+#if defined(_WIN32)
+            _close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+    }
+
+    // False once opening or any commit failed; later records are dropped.
+    bool ok() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ok_;
+    }
+
+    void input(std::uint64_t tick, const Input &input) { append(journal::kInput, tick, &input, sizeof(input), nullptr, 0); }
+
+    void checkpoint(const Simulator &simulator, const ScenarioState &scenario) {
+        journal::Checkpoint checkpoint;
+        checkpoint.state = simulator.state();
+        checkpoint.wind = simulator.wind();
+        checkpoint.scenario = scenario;
+        checkpoint.tick = simulator.tick();
+        checkpoint.passedWords = static_cast<std::uint32_t>((simulator.course().size() + 63) / 64);
+        append(journal::kCheckpoint, checkpoint.tick, &checkpoint, sizeof(checkpoint), simulator.passedBits(),
+               checkpoint.passedWords * sizeof(std::uint64_t));
+    }
+
+    // Blocks until everything appended so far is on disk.
+    bool flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const std::uint64_t target = appended_;
+        flushWanted_ = true;
+        wake_.notify_one();
+        durableChanged_.wait(lock, [&] { return durable_ >= target || !ok_; });
+        return ok_;
+    }
+
+    JournalStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    std::chrono::milliseconds maxDelay_;
+    int fd_{-1};
+    std::thread writer_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable durableChanged_;
+    std::vector<unsigned char> pending_;
+    Clock::time_point oldestPending_{};
+    std::uint64_t appended_{0};  // bytes handed to append()
+    std::uint64_t durable_{0};   // bytes committed with fdatasync
+    bool flushWanted_{false};
+    bool stopping_{false};
+    bool ok_{false};
+    JournalStats stats_;
+
+    bool openFile(const std::string &path, bool create) {
+#if defined(_WIN32)
+        const int flags = _O_WRONLY | _O_BINARY | (create ? _O_CREAT | _O_TRUNC : 0);
+        fd_ = _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        const int flags = O_WRONLY | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0);
+        fd_ = ::open(path.c_str(), flags, 0644);
+#endif
+        return fd_ >= 0;
+    }
+
+    void start() {
+        if (!ok_) {
+            return;
+        }
+        pending_.reserve(2 * kGroupBytes);
+        writer_ = std::thread([this] { run(); });
+    }
+
+    void append(journal::RecordType type, std::uint64_t tick, const void *payload, std::size_t size,
+                const void *extra, std::size_t extraSize) {
+        journal::RecordHeader header;
+        header.type = type;
+        header.size = static_cast<std::uint32_t>(size + extraSize);
+        header.tick = tick;
+        header.checksum = journal::crc32(extra, extraSize, journal::crc32(payload, size, journal::crc32(&header, sizeof(header))));
+        const auto *head = reinterpret_cast<const unsigned char *>(&header);
+        const auto *body = static_cast<const unsigned char *>(payload);
+        const auto *tail = static_cast<const unsigned char *>(extra);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!ok_ || stopping_) {
+            return;
+        }
+        const bool first = pending_.empty();
+        if (first) {
+            oldestPending_ = Clock::now();
+        }
+        pending_.insert(pending_.end(), head, head + sizeof(header));
+        pending_.insert(pending_.end(), body, body + size);
+        pending_.insert(pending_.end(), tail, tail + extraSize);
+        appended_ += sizeof(header) + size + extraSize;
+        ++stats_.records;
+        // The writer sleeps while nothing is pending and otherwise only needs
+        // waking early for a full group.
+        const bool wake = first || pending_.size() >= kGroupBytes;
+        lock.unlock();
+        if (wake) {
+            wake_.notify_one();
+        }
+    }
+
+    void run() {
+        std::vector<unsigned char> group;
+        group.reserve(2 * kGroupBytes);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break;
+            }
+            wake_.wait_until(lock, oldestPending_ + maxDelay_, [&] {
+                return stopping_ || flushWanted_ || pending_.size() >= kGroupBytes;
+            });
+            flushWanted_ = false;
+            group.swap(pending_);
+            const Clock::time_point oldest = oldestPending_;
+            const std::uint64_t target = appended_;
+            lock.unlock();
+
+            const bool written = writeAll(group.data(), group.size()) && sync();
+            const auto delay = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - oldest);
+            const std::size_t bytes = group.size();
+            group.clear();
+
+            lock.lock();
+            if (!written) {
+                ok_ = false;
+                pending_.clear();
+                durableChanged_.notify_all();
+                break;
+            }
+            durable_ = target;
+            stats_.bytes += bytes;
+            ++stats_.commits;
+            stats_.maxCommitDelay = std::max(stats_.maxCommitDelay, delay);
+            durableChanged_.notify_all();
+        }
+    }
+
+    bool writeAll(const void *data, std::size_t size) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        while (size > 0) {
+#if defined(_WIN32)
+            const int chunk = static_cast<int>(std::min<std::size_t>(size, 1u << 30));
+            const int written = _write(fd_, bytes, static_cast<unsigned int>(chunk));
+#else
+            const ssize_t written = ::write(fd_, bytes, size);
+#endif
+            if (written <= 0) {
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    bool sync() {
+#if defined(_WIN32)
+        return _commit(fd_) == 0;
+#elif defined(__APPLE__)
+        return ::fsync(fd_) == 0;
+#else
+        return ::fdatasync(fd_) == 0;
+#endif
+    }
+};
+
+}  // namespace sim
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sim {
+
+// Log-linear histogram in the spirit of HdrHistogram: values below 128 get
+// exact buckets, larger values 64 sub-buckets per power of two, so every
+// recorded value is reproduced to within 1.6% with a fixed 30 KiB footprint and
+// O(1) allocation-free recording.
+class LatencyHistogram {
+  public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr std::uint64_t kSubBuckets = std::uint64_t{1} << kSubBucketBits;
+    static constexpr std::uint64_t kHalf = kSubBuckets / 2;
+    static constexpr std::size_t kBucketCount = kSubBuckets + (64 - kSubBucketBits + 1) * kHalf;
+
+    void record(std::uint64_t value) {
+        ++counts_[indexOf(value)];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max() const { return max_; }
+    double mean() const { return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+    // Upper edge of the bucket holding the given percentile (0-100].
+    std::uint64_t percentile(double percent) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const double clamped = std::clamp(percent, 0.0, 100.0);
+        const auto target = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(clamped / 100.0 * static_cast<double>(count_) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(max_, upperEdge(i));
+            }
+        }
+        return max_;
+    }
+
+    void reset() { *this = LatencyHistogram{}; }
+
+  private:
+    std::array<std::uint64_t, kBucketCount> counts_{};
+    std::uint64_t count_{0};
+    std::uint64_t sum_{0};
+    std::uint64_t max_{0};
+
+    static int msb(std::uint64_t value) {
+        int bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+    }
+
+    static std::size_t indexOf(std::uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        const int shift = msb(value) - (kSubBucketBits - 1);
+        const std::uint64_t sub = value >> shift;  // in [kHalf, kSubBuckets)
+        return static_cast<std::size_t>(kSubBuckets + static_cast<std::uint64_t>(shift - 1) * kHalf + (sub - kHalf));
+    }
+
+    static std::uint64_t upperEdge(std::size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        const std::uint64_t rel = index - kSubBuckets;
+        const int shift = static_cast<int>(rel / kHalf) + 1;
+        const std::uint64_t sub = kHalf + rel % kHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+// End-to-end latency from the moment a command has been read to the moment the
+// frame that reflects it has been flushed out of the process. Any front end
+// (console, scripted, remote) marks the same two points.
+class InputLatencyTracker {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void inputReceived() {
+        pendingSince_ = Clock::now();
+        pending_ = true;
+    }
+
+    void frameDisplayed() {
+        if (!pending_) {
+            return;
+        }
+        pending_ = false;
+        last_ = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - pendingSince_).count());
+        histogram_.record(last_);
+    }
+
+    // A command that produces no frame (e.g. help) is not counted.
+    void cancel() { pending_ = false; }
+
+    std::uint64_t lastNs() const { return last_; }
+    const LatencyHistogram &histogram() const { return histogram_; }
+
+  private:
+    Clock::time_point pendingSince_{};
+    bool pending_{false};
+    std::uint64_t last_{0};
+    LatencyHistogram histogram_;
+};
+
+}  // namespace sim
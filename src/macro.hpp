@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+// On-disk layout of a macro library:
+//
+//   FileHeader
+//   Entry[count]     name, first input and length of each macro
+//   Input[...]       every macro's inputs, packed back to back
+//
+// Inputs are stored exactly as the console parsed them, so loading is one map
+// and a copy per macro with no text parsing. The file is rewritten whole and
+// renamed into place, so a crash leaves either the old or the new library.
+namespace macro {
+
+constexpr std::uint32_t kMagic = 0x434d5346;  // "FSMC"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kMaxName = 31;
+
+static_assert(std::is_trivially_copyable_v<Input> && sizeof(Input) == 4 * sizeof(double),
+              "macro files store Input as four raw doubles");
+
+struct FileHeader {
+    std::uint32_t magic{kMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t count{0};
+    std::uint32_t inputBytes{sizeof(Input)};
+};
+
+struct Entry {
+    char name[kMaxName + 1]{};
+    std::uint64_t first{0};
+    std::uint32_t length{0};
+    std::uint32_t reserved{0};
+};
+
+inline bool validName(const std::string &name) {
+    return !name.empty() && name.size() <= kMaxName &&
+           std::all_of(name.begin(), name.end(), [](char c) { return c > ' ' && c != 0x7f; });
+}
+
+}  // namespace macro
+
+// Named sequences of parsed console inputs. While recording, every input the
+// console steps with is appended to the open macro; play hands the stored
+// inputs straight to Simulator::step.
+class MacroLibrary {
+  public:
+    struct Macro {
+        std::string name;
+        std::vector<Input> inputs;
+    };
+
+    // A missing file is an empty library, not an error.
+    bool load(const std::string &path, std::string &error) {
+        macros_.clear();
+        if (!std::filesystem::exists(path)) {
+            return true;
+        }
+        MappedFile file;
+        if (!file.open(path) || file.size() < sizeof(macro::FileHeader)) {
+            error = "매크로 파일을 읽을 수 없습니다: " + path;
+            return false;
+        }
+        macro::FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        const std::size_t inputsAt = sizeof(header) + std::size_t{header.count} * sizeof(macro::Entry);
+        if (header.magic != macro::kMagic || header.version != macro::kVersion ||
+            header.inputBytes != sizeof(Input) || file.size() < inputsAt) {
+            error = "매크로 파일 형식이 올바르지 않습니다: " + path;
+            return false;
+        }
+        const std::size_t stored = (file.size() - inputsAt) / sizeof(Input);
+        macros_.reserve(header.count);
+        for (std::uint32_t i = 0; i < header.count; ++i) {
+            macro::Entry entry;
+            std::memcpy(&entry, file.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+            entry.name[macro::kMaxName] = '\0';
+            if (entry.first > stored || entry.length > stored - entry.first) {
+                error = "매크로 파일이 잘렸습니다: " + path;
+                macros_.clear();
+                return false;
+            }
+            Macro &m = macros_.emplace_back();
+            m.name = entry.name;
+            m.inputs.resize(entry.length);
+            std::memcpy(m.inputs.data(), file.data() + inputsAt + entry.first * sizeof(Input),
+                        entry.length * sizeof(Input));
+        }
+        std::sort(macros_.begin(), macros_.end(), [](const Macro &a, const Macro &b) { return a.name < b.name; });
+        return true;
+    }
+
+    bool save(const std::string &path) const {
+        macro::FileHeader header;
+        header.count = static_cast<std::uint32_t>(macros_.size());
+        std::vector<macro::Entry> entries(macros_.size());
+        std::uint64_t first = 0;
+        for (std::size_t i = 0; i < macros_.size(); ++i) {
+            std::memcpy(entries[i].name, macros_[i].name.data(), macros_[i].name.size());
+            entries[i].first = first;
+            entries[i].length = static_cast<std::uint32_t>(macros_[i].inputs.size());
+            first += macros_[i].inputs.size();
+        }
+
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(entries.data()),
+                      static_cast<std::streamsize>(entries.size() * sizeof(macro::Entry)));
+            for (const Macro &m : macros_) {
+                out.write(reinterpret_cast<const char *>(m.inputs.data()),
+                          static_cast<std::streamsize>(m.inputs.size() * sizeof(Input)));
+            }
+            if (!out) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        return !ec;
+    }
+
+    // Starts capturing into `name`; the macro replaces any older one with the
+    // same name when recording stops.
+    bool startRecording(const std::string &name) {
+        if (!macro::validName(name)) {
+            return false;
+        }
+        recording_ = true;
+        open_.name = name;
+        open_.inputs.clear();
+        return true;
+    }
+
+    void record(const Input &input) {
+        if (recording_) {
+            open_.inputs.push_back(input);
+        }
+    }
+
+    // Stores the open macro and returns it; nullptr if nothing was recording.
+    const Macro *stopRecording() {
+        if (!recording_) {
+            return nullptr;
+        }
+        recording_ = false;
+        auto it = std::lower_bound(macros_.begin(), macros_.end(), open_.name,
+                                   [](const Macro &m, const std::string &name) { return m.name < name; });
+        if (it == macros_.end() || it->name != open_.name) {
+            it = macros_.insert(it, Macro{});
+        }
+        *it = std::move(open_);
+        open_ = Macro{};
+        return &*it;
+    }
+
+    bool recording() const { return recording_; }
+    const Macro &open() const { return open_; }
+
+    const Macro *find(const std::string &name) const {
+        auto it = std::lower_bound(macros_.begin(), macros_.end(), name,
+                                   [](const Macro &m, const std::string &key) { return m.name < key; });
+        return it != macros_.end() && it->name == name ? &*it : nullptr;
+    }
+
+    // Sorted by name.
+    const std::vector<Macro> &macros() const { return macros_; }
+
+  private:
+    std::vector<Macro> macros_;
+    Macro open_;
+    bool recording_{false};
+};
+
+}  // namespace sim
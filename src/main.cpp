@@ -1,234 +1,146 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
-#include <random>
-#include <sstream>
+#include <limits>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
-namespace sim {
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
-constexpr double kDegToRad = M_PI / 180.0;
+#include "alloc_tracker.hpp"
+#include "dataset.hpp"
+#include "es_trainer.hpp"
+#include "job_system.hpp"
+#include "journal.hpp"
+#include "latency.hpp"
+#include "macro.hpp"
+#include "numa.hpp"
+#include "perf_counters.hpp"
+#include "plugin.hpp"
+#include "scenario.hpp"
+#include "script_controller.hpp"
+#include "shm_ring.hpp"
+#include "simulator.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 
-struct Vec3 {
-    double x;
-    double y;
-    double z;
-
-    Vec3 operator+(const Vec3 &other) const { return {x + other.x, y + other.y, z + other.z}; }
-    Vec3 operator-(const Vec3 &other) const { return {x - other.x, y - other.y, z - other.z}; }
-    Vec3 operator*(double scalar) const { return {x * scalar, y * scalar, z * scalar}; }
-    Vec3 operator/(double scalar) const { return {x / scalar, y / scalar, z / scalar}; }
-
-    Vec3 &operator+=(const Vec3 &other) {
-        x += other.x;
-        y += other.y;
-        z += other.z;
-        return *this;
+// Route every heap allocation in the process through the accounting hooks.
+void *operator new(std::size_t size) {
+    sim::alloc::onAllocate(size);
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
     }
+    throw std::bad_alloc();
+}
 
-    Vec3 &operator-=(const Vec3 &other) {
-        x -= other.x;
-        y -= other.y;
-        z -= other.z;
-        return *this;
-    }
-
-    Vec3 &operator*=(double scalar) {
-        x *= scalar;
-        y *= scalar;
-        z *= scalar;
-        return *this;
-    }
-};
-
-inline double dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+void *operator new[](std::size_t size) { return ::operator new(size); }
 
-inline Vec3 cross(const Vec3 &a, const Vec3 &b) {
-    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    sim::alloc::onAllocate(size);
+    return std::malloc(size == 0 ? 1 : size);
 }
 
-inline double length(const Vec3 &v) { return std::sqrt(dot(v, v)); }
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return ::operator new(size, tag); }
 
-inline Vec3 normalize(const Vec3 &v) {
-    const double len = length(v);
-    if (len < 1e-6) {
-        return {0.0, 0.0, 0.0};
+void operator delete(void *p) noexcept {
+    if (p != nullptr) {
+        sim::alloc::onFree();
+        std::free(p);
     }
-    return v / len;
 }
 
-Vec3 rotateX(const Vec3 &v, double radians) {
-    const double c = std::cos(radians);
-    const double s = std::sin(radians);
-    return {v.x, v.y * c - v.z * s, v.y * s + v.z * c};
-}
+void operator delete[](void *p) noexcept { ::operator delete(p); }
+void operator delete(void *p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void *p, std::size_t) noexcept { ::operator delete(p); }
 
-Vec3 rotateY(const Vec3 &v, double radians) {
-    const double c = std::cos(radians);
-    const double s = std::sin(radians);
-    return {v.x * c + v.z * s, v.y, -v.x * s + v.z * c};
-}
+// Over-aligned types (Course columns, cache-line padded counters) come through
+// the align_val_t forms; the size is rounded up as aligned_alloc requires.
+// Both helpers stay out of line: once GCC inlines an aligned new/delete pair
+// it flags the free() as not matching operator new (-Wmismatched-new-delete).
+#if defined(_MSC_VER)
+#define SIM_NOINLINE __declspec(noinline)
+#else
+#define SIM_NOINLINE __attribute__((noinline))
+#endif
 
-Vec3 rotateZ(const Vec3 &v, double radians) {
-    const double c = std::cos(radians);
-    const double s = std::sin(radians);
-    return {v.x * c - v.y * s, v.x * s + v.y * c, v.z};
+SIM_NOINLINE void *allocateAligned(std::size_t size, std::align_val_t alignment) noexcept {
+    sim::alloc::onAllocate(size);
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+#if defined(_WIN32)
+    return _aligned_malloc(rounded, align);
+#else
+    return std::aligned_alloc(align, rounded);
+#endif
 }
 
-Vec3 orientationForward(double yaw, double pitch, double roll) {
-    Vec3 forward{0.0, 0.0, 1.0};
-    forward = rotateZ(forward, roll);
-    forward = rotateX(forward, pitch);
-    forward = rotateY(forward, yaw);
-    return normalize(forward);
+SIM_NOINLINE void releaseAligned(void *p) noexcept {
+    if (p != nullptr) {
+        sim::alloc::onFree();
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
 }
 
-Vec3 orientationUp(double yaw, double pitch, double roll) {
-    Vec3 up{0.0, 1.0, 0.0};
-    up = rotateZ(up, roll);
-    up = rotateX(up, pitch);
-    up = rotateY(up, yaw);
-    return normalize(up);
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *p = allocateAligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
 }
 
-struct Input {
-    double throttleDelta{0.0};
-    double pitchDelta{0.0};
-    double yawDelta{0.0};
-    double rollDelta{0.0};
-};
-
-struct Ring {
-    Vec3 position{};
-    double radius{40.0};
-    bool passed{false};
-};
+void *operator new[](std::size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
 
-struct FlightState {
-    Vec3 position{0.0, 80.0, 0.0};
-    Vec3 velocity{0.0, 0.0, 30.0};
-    double yaw{0.0};
-    double pitch{0.0};
-    double roll{0.0};
-    double throttle{0.4};
-    double fuel{120.0};
-    int score{0};
-};
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
 
-class Simulator {
-  public:
-    explicit Simulator(std::size_t ringCount)
-        : rings_(generateRings(ringCount)), rng_(static_cast<unsigned int>(std::time(nullptr))) {}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
 
-    void step(const Input &input, double dt) {
-        applyInput(input);
-        integrate(dt);
-        checkRings();
-        clampToGround();
-    }
+void operator delete(void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
 
-    const FlightState &state() const { return state_; }
-    const std::vector<Ring> &rings() const { return rings_; }
+// Tokenises in place with string_view so parsing a command never touches the heap.
+sim::Input parseInput(std::string_view line) {
+    SIM_TRACE_SCOPE("parseInput");
+    sim::alloc::TagScope tag(sim::alloc::kParse);
+    sim::Input input;
 
-  private:
-    FlightState state_{};
-    std::vector<Ring> rings_;
-    std::mt19937 rng_;
-
-    static std::vector<Ring> generateRings(std::size_t count) {
-        std::vector<Ring> result;
-        result.reserve(count);
-        std::mt19937 rng(static_cast<unsigned int>(std::time(nullptr)));
-        std::uniform_real_distribution<double> lateral(-220.0, 220.0);
-        std::uniform_real_distribution<double> altitude(40.0, 220.0);
-        const double spacing = 320.0;
-
-        for (std::size_t i = 0; i < count; ++i) {
-            Ring ring;
-            ring.position = {lateral(rng), altitude(rng), spacing * static_cast<double>(i + 1)};
-            ring.radius = 45.0;
-            ring.passed = false;
-            result.push_back(ring);
-        }
-        return result;
-    }
-
-    void applyInput(const Input &input) {
-        state_.throttle = std::clamp(state_.throttle + input.throttleDelta, 0.0, 1.0);
-        state_.pitch = std::clamp(state_.pitch + input.pitchDelta, -45.0 * kDegToRad, 45.0 * kDegToRad);
-        state_.yaw += input.yawDelta;
-        state_.roll = std::clamp(state_.roll + input.rollDelta, -80.0 * kDegToRad, 80.0 * kDegToRad);
-    }
-
-    void integrate(double dt) {
-        constexpr double mass = 750.0;                   // kg
-        constexpr double thrustPower = 26000.0;          // N
-        constexpr double dragCoefficient = 0.04;         // simplified quadratic drag
-        constexpr double liftCoefficient = 0.018;        // scales with speed^2
-        constexpr double gravity = 9.81;                 // m/s^2
-        constexpr double fuelBurnPerSec = 0.25;          // fuel units per second at full throttle
-        constexpr double rollYawCoupling = 0.35;         // roll adds slight yawing turn
-
-        const Vec3 forward = orientationForward(state_.yaw, state_.pitch, state_.roll);
-        const Vec3 up = orientationUp(state_.yaw, state_.pitch, state_.roll);
-
-        // Basic forces
-        const Vec3 thrust = forward * (thrustPower * state_.throttle);
-        const double speed = length(state_.velocity);
-        const Vec3 drag = state_.velocity * (-dragCoefficient * speed);
-        const Vec3 lift = up * (liftCoefficient * speed * speed);
-        const Vec3 gravityForce{0.0, -mass * gravity, 0.0};
-
-        // Banked turn: roll causes gradual yaw change to mimic coordinated turns.
-        state_.yaw += (state_.roll * rollYawCoupling) * dt;
-
-        const Vec3 acceleration = (thrust + drag + lift + gravityForce) / mass;
-        state_.velocity += acceleration * dt;
-        state_.position += state_.velocity * dt;
-
-        const double fuelUse = fuelBurnPerSec * state_.throttle * dt;
-        state_.fuel = std::max(0.0, state_.fuel - fuelUse);
-
-        if (state_.fuel <= 0.0) {
-            state_.throttle = 0.0;
-        }
-    }
-
-    void clampToGround() {
-        if (state_.position.y < 0.0) {
-            state_.position.y = 0.0;
-            if (state_.velocity.y < 0.0) {
-                state_.velocity.y *= -0.2;  // dampen bounce
-            }
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; };
+    std::size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && isSpace(line[pos])) {
+            ++pos;
         }
-    }
-
-    void checkRings() {
-        for (auto &ring : rings_) {
-            if (ring.passed) {
-                continue;
-            }
-            const double distance = length(state_.position - ring.position);
-            if (distance <= ring.radius) {
-                ring.passed = true;
-                state_.score += 100;
-            }
+        std::size_t end = pos;
+        while (end < line.size() && !isSpace(line[end])) {
+            ++end;
         }
-    }
-};
-
-}  // namespace sim
+        const std::string_view token = line.substr(pos, end - pos);
+        pos = end;
 
-sim::Input parseInput(const std::string &line) {
-    sim::Input input;
-    std::istringstream iss(line);
-    std::string token;
-
-    while (iss >> token) {
         if (token == "w" || token == "pitch+" || token == "p+") {
             input.pitchDelta += 0.8 * sim::kDegToRad;
         } else if (token == "s" || token == "pitch-" || token == "p-") {
@@ -251,17 +163,88 @@ sim::Input parseInput(const std::string &line) {
     return input;
 }
 
-void printHUD(const sim::Simulator &simulator, int tick, double dt) {
-    const auto &state = simulator.state();
-    const auto &rings = simulator.rings();
+// Keeps the most recent flight events for the HUD. Filled by the simulator's
+// event bus after each step, so the HUD never has to diff states to notice a
+// ring pass or a landing.
+class HudEventLog : public sim::EventSubscriber {
+  public:
+    static constexpr std::size_t kShown = 4;
 
-    const int remaining = static_cast<int>(std::count_if(rings.begin(), rings.end(), [](const sim::Ring &r) {
-        return !r.passed;
-    }));
+    void onEvents(std::uint64_t tick, const sim::EventBuffer &events, const sim::FlightState &) override {
+        for (const sim::Event &event : events) {
+            entries_[next_ % kShown] = {tick, event};
+            ++next_;
+        }
+    }
 
-    std::cout << "\n=== 틱 " << tick << " (" << std::fixed << std::setprecision(1) << dt
+    void print(std::ostream &out) const {
+        const std::size_t count = std::min(next_, kShown);
+        for (std::size_t i = next_ - count; i < next_; ++i) {
+            const Entry &entry = entries_[i % kShown];
+            out << "  [틱 " << entry.tick << "] ";
+            switch (entry.event.type) {
+                case sim::EventType::kRingPassed:
+                    out << "링 #" << entry.event.id + 1 << " 통과! +" << sim::rules::kRingScore << "\n";
+                    break;
+                case sim::EventType::kFuelLow:
+                    out << "연료 부족 경고: " << entry.event.value << " u 남음\n";
+                    break;
+                case sim::EventType::kFuelEmpty:
+                    out << "연료 소진! 엔진이 꺼졌습니다.\n";
+                    break;
+                case sim::EventType::kGroundContact:
+                    out << "지면 접촉 (수직 속도 " << entry.event.value << " m/s)\n";
+                    break;
+                case sim::EventType::kTimer:
+                    out << "예약 이벤트 #" << entry.event.id << "\n";
+                    break;
+                case sim::EventType::kScenario:
+                    out << "시나리오 이벤트 #" << entry.event.id << " (" << entry.event.value << ")\n";
+                    break;
+                case sim::EventType::kScenarioEnd:
+                    out << (entry.event.value > 0.0 ? "시나리오 성공!\n" : "시나리오 실패\n");
+                    break;
+            }
+        }
+    }
+
+  private:
+    struct Entry {
+        std::uint64_t tick{0};
+        sim::Event event;
+    };
+
+    std::array<Entry, kShown> entries_{};
+    std::size_t next_{0};
+};
+
+// Ends the interactive flight when the --time-limit timer fires.
+class TimeLimit : public sim::EventSubscriber {
+  public:
+    static constexpr std::uint32_t kTag = 1;
+
+    void onEvents(std::uint64_t, const sim::EventBuffer &events, const sim::FlightState &) override {
+        for (const sim::Event &event : events) {
+            expired_ = expired_ || (event.type == sim::EventType::kTimer && event.id == kTag);
+        }
+    }
+
+    bool expired() const { return expired_; }
+
+  private:
+    bool expired_{false};
+};
+
+void printHUD(std::ostream &out, const sim::Simulator &simulator, int tick, double dt,
+              const sim::InputLatencyTracker &latency, const HudEventLog &events) {
+    SIM_TRACE_SCOPE("printHUD");
+    sim::alloc::TagScope tag(sim::alloc::kHud);
+    const auto &state = simulator.state();
+    const std::size_t remaining = simulator.remainingRings();
+
+    out << "\n=== 틱 " << tick << " (" << std::fixed << std::setprecision(1) << dt
               << "s) ===\n";
-    std::cout << std::setprecision(2)
+    out << std::setprecision(2)
               << "위치 (x,y,z): " << state.position.x << ", " << state.position.y << ", "
               << state.position.z << " m\n"
               << "속도: " << sim::length(state.velocity) << " m/s  (전진="
@@ -273,6 +256,33 @@ void printHUD(const sim::Simulator &simulator, int tick, double dt) {
               << state.pitch / sim::kDegToRad << " / " << state.roll / sim::kDegToRad << "\n"
               << "스로틀: " << state.throttle * 100.0 << "%  연료: " << state.fuel << " u\n"
               << "점수: " << state.score << "  남은 링: " << remaining << "\n";
+    const sim::Vec3 &wind = simulator.wind();
+    if (wind.x != 0.0 || wind.y != 0.0 || wind.z != 0.0) {
+        out << "바람 (x,y,z): " << wind.x << ", " << wind.y << ", " << wind.z << " m/s\n";
+    }
+    if (latency.histogram().count() > 0) {
+        const auto &h = latency.histogram();
+        out << "입력→화면 지연 (us): 최근 " << static_cast<double>(latency.lastNs()) / 1000.0 << "  p50 "
+                  << static_cast<double>(h.percentile(50.0)) / 1000.0 << "  p99 "
+                  << static_cast<double>(h.percentile(99.0)) / 1000.0 << "\n";
+    }
+    events.print(out);
+}
+
+void printLatencySummary(const sim::LatencyHistogram &h) {
+    if (h.count() == 0) {
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "입력→화면 지연 (us, " << h.count() << "회): 평균 "
+              << h.mean() / 1000.0;
+    const struct {
+        const char *label;
+        double percent;
+    } kPercentiles[] = {{"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}};
+    for (const auto &p : kPercentiles) {
+        std::cout << "  " << p.label << " " << static_cast<double>(h.percentile(p.percent)) / 1000.0;
+    }
+    std::cout << "  최대 " << static_cast<double>(h.max()) / 1000.0 << "\n";
 }
 
 void printHelp() {
@@ -285,25 +295,913 @@ void printHelp() {
               << "  d / yaw+ / y+            : 우선회 (요 +)\n"
               << "  q / roll- / r-           : 좌측 롤\n"
               << "  e / roll+ / r+           : 우측 롤\n"
+              << "  record <이름>            : 이후 입력을 매크로로 기록\n"
+              << "  stop                     : 기록을 끝내고 매크로 파일에 저장\n"
+              << "  play <이름> [xN]         : 매크로 재생 (xN: N틱마다 한 번만 HUD 표시하는 빨리 감기)\n"
+              << "  macros                   : 저장된 매크로 목록\n"
+              << "  trace                    : 타임라인 트레이스 저장 (--trace 사용 시)\n"
               << "  help                     : 도움말 다시 보기\n"
               << "  exit                     : 즉시 종료\n";
 }
 
-int main() {
+struct Options {
+    bool train{false};
+    std::size_t trainIterations{50};
+    std::string trainOutput{"es_params.txt"};
+    sim::EsConfig es{};
+    std::string demoDirectory;
+    std::string datasetInfo;
+    std::string telemetryPath;
+    bool telemetryCompress{false};
+    sim::IoBackend telemetryIo{sim::IoBackend::kAuto};
+    std::string tracePath;
+    std::size_t traceSampleEvery{1};
+    bool perf{false};
+    bool allocStats{false};
+    bool allocCheck{false};
+    bool numaBench{false};
+    std::size_t courseBenchRings{0};
+    std::size_t scriptBenchAircraft{0};
+    std::size_t timeLimitSeconds{0};
+    std::string scenarioPath;
+    bool scenarioDump{false};
+    std::string pluginPath;
+    std::string macroPath{"flightsim_macros.bin"};
+    std::string journalPath;
+    std::string resumePath;
+    std::string shmName;
+};
+
+bool parseCount(const char *text, std::size_t &out) {
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    out = static_cast<std::size_t>(value);
+    return true;
+}
+
+// Console macro commands: "record <name>", "stop", "play <name> [xN]" and
+// "macros". Any other line is flight input.
+struct MacroCommand {
+    enum Kind { kNone, kRecord, kStop, kPlay, kList, kInvalid };
+    Kind kind{kNone};
+    std::string name;
+    std::size_t every{1};  // play: show the HUD every N replayed ticks
+};
+
+MacroCommand parseMacroCommand(std::string_view line) {
+    std::string_view words[4];
+    std::size_t count = 0;
+    for (std::size_t pos = 0; pos < line.size();) {
+        pos = line.find_first_not_of(" \t\r", pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        const std::size_t end = std::min(line.find_first_of(" \t\r", pos), line.size());
+        if (count == 4) {
+            return {MacroCommand::kInvalid, {}, 1};
+        }
+        words[count++] = line.substr(pos, end - pos);
+        pos = end;
+    }
+    if (count == 0) {
+        return {};
+    }
+    MacroCommand command;
+    if (words[0] == "record") {
+        command.kind = count == 2 ? MacroCommand::kRecord : MacroCommand::kInvalid;
+    } else if (words[0] == "stop") {
+        command.kind = count == 1 ? MacroCommand::kStop : MacroCommand::kInvalid;
+    } else if (words[0] == "macros") {
+        command.kind = count == 1 ? MacroCommand::kList : MacroCommand::kInvalid;
+    } else if (words[0] == "play") {
+        command.kind = count == 2 || count == 3 ? MacroCommand::kPlay : MacroCommand::kInvalid;
+        if (count == 3) {
+            const std::string factor(words[2].substr(1));
+            if (words[2][0] != 'x' || !parseCount(factor.c_str(), command.every) || command.every == 0) {
+                command.kind = MacroCommand::kInvalid;
+            }
+        }
+    } else {
+        return {};
+    }
+    if (count >= 2) {
+        command.name = std::string(words[1]);
+    }
+    return command;
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        std::size_t value = 0;
+
+        if (arg == "--train") {
+            options.train = true;
+        } else if (arg == "--iterations" && hasValue && parseCount(argv[++i], value)) {
+            options.trainIterations = value;
+        } else if (arg == "--pairs" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.es.pairs = value;
+        } else if (arg == "--episodes" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.es.episodesPerCandidate = value;
+        } else if (arg == "--compact-state") {
+            options.es.storage = sim::StateStorage::kCompact;
+        } else if (arg == "--lanes" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.es.batchLanes = value;
+        } else if (arg == "--threads" && hasValue && parseCount(argv[++i], value)) {
+            options.es.threads = static_cast<unsigned int>(value);
+        } else if (arg == "--seed" && hasValue && parseCount(argv[++i], value)) {
+            options.es.seed = value;
+        } else if (arg == "--out" && hasValue) {
+            options.trainOutput = argv[++i];
+        } else if (arg == "--record-demos" && hasValue) {
+            options.demoDirectory = argv[++i];
+        } else if (arg == "--dataset-info" && hasValue) {
+            options.datasetInfo = argv[++i];
+        } else if (arg == "--telemetry" && hasValue) {
+            options.telemetryPath = argv[++i];
+        } else if (arg == "--telemetry-compress") {
+            options.telemetryCompress = true;
+        } else if (arg == "--telemetry-io" && hasValue && (std::string_view(argv[i + 1]) == "uring" ||
+                                                          std::string_view(argv[i + 1]) == "thread")) {
+            options.telemetryIo = std::string_view(argv[++i]) == "uring" ? sim::IoBackend::kUring : sim::IoBackend::kThread;
+        } else if (arg == "--trace" && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (arg == "--perf") {
+            options.perf = true;
+        } else if (arg == "--alloc-stats") {
+            options.allocStats = true;
+        } else if (arg == "--alloc-check") {
+            options.allocCheck = true;
+        } else if (arg == "--numa") {
+            options.es.pinThreads = true;
+        } else if (arg == "--numa-bench") {
+            options.numaBench = true;
+        } else if (arg == "--course-bench" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.courseBenchRings = value;
+        } else if (arg == "--script-bench" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.scriptBenchAircraft = value;
+        } else if (arg == "--scenario" && hasValue) {
+            options.scenarioPath = argv[++i];
+        } else if (arg == "--macros" && hasValue) {
+            options.macroPath = argv[++i];
+        } else if (arg == "--journal" && hasValue) {
+            options.journalPath = argv[++i];
+        } else if (arg == "--resume" && hasValue) {
+            options.resumePath = argv[++i];
+        } else if (arg == "--shm" && hasValue && argv[i + 1][0] != '\0') {
+            const std::string name = argv[++i];
+            options.shmName = name.front() == '/' ? name : "/" + name;
+        } else if (arg == "--plugin" && hasValue) {
+            options.pluginPath = argv[++i];
+        } else if (arg == "--scenario-dump") {
+            options.scenarioDump = true;
+        } else if (arg == "--time-limit" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.timeLimitSeconds = value;
+        } else if (arg == "--trace-sample" && hasValue && parseCount(argv[++i], value) && value > 0) {
+            options.traceSampleEvery = value;
+        } else {
+            std::cerr << "[error] 알 수 없는 옵션 또는 잘못된 값: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool dumpTrace(const std::string &path) {
+    if (path.empty()) {
+        std::cout << "트레이스가 꺼져 있습니다. --trace <파일> 로 실행하세요.\n";
+        return false;
+    }
+    if (!sim::trace::Recorder::instance().writeChromeJson(path)) {
+        std::cerr << "[error] 트레이스를 저장할 수 없습니다: " << path << "\n";
+        return false;
+    }
+    std::cout << "트레이스 저장: " << path << " (chrome://tracing 또는 ui.perfetto.dev)\n";
+    return true;
+}
+
+// Discards everything written to it; lets the HUD formatting path run in the
+// allocation check without flooding the terminal.
+class NullBuffer : public std::streambuf {
+  protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+// Drives parse -> step -> HUD formatting from a fixed command script. After a
+// warm-up (first-use buffers, stream locale caches) any heap allocation in the
+// steady state is a failure.
+int runAllocationCheck() {
+    constexpr double dt = 0.1;
+    constexpr int kWarmupTicks = 200;
+    constexpr int kCheckedTicks = 20000;
+    const char *const script[] = {"+ +", "w", "throttle+ pitch+ yaw+ roll+ throttle- pitch- yaw- roll-",
+                                  "d e", "", "s q", "- a", "t+ p+ y+ r+"};
+    constexpr int kScriptLength = static_cast<int>(sizeof(script) / sizeof(script[0]));
+
+    sim::Simulator simulator(6, 1234u);
+    sim::InputLatencyTracker latency;
+    HudEventLog events;
+    simulator.subscribe(&events);
+    NullBuffer nullBuffer;
+    std::ostream hud(&nullBuffer);
+    std::string line;
+    line.reserve(128);
+
+    auto tick = [&](int i) {
+        line.assign(script[i % kScriptLength]);
+        latency.inputReceived();
+        const sim::Input input = parseInput(line);
+        simulator.schedule(1 + i % 50, 2);  // keeps ~50 timers in flight
+        simulator.step(input, dt);
+        printHUD(hud, simulator, i, dt, latency, events);
+        latency.frameDisplayed();
+    };
+
+    for (int i = 0; i < kWarmupTicks; ++i) {
+        tick(i);
+    }
+    const std::uint64_t before = sim::alloc::totalAllocations();
+    const std::uint64_t violationsBefore = sim::alloc::counters().violations.load();
+    {
+        sim::alloc::NoAllocScope noAlloc;
+        for (int i = kWarmupTicks; i < kWarmupTicks + kCheckedTicks; ++i) {
+            tick(i);
+        }
+    }
+    const std::uint64_t allocations = sim::alloc::totalAllocations() - before;
+    const std::uint64_t violations = sim::alloc::counters().violations.load() - violationsBefore;
+
+    std::cout << "할당 검사: 워밍업 " << kWarmupTicks << "틱 후 " << kCheckedTicks << "틱 동안 힙 할당 " << allocations
+              << "회\n";
+    if (violations != 0) {
+        sim::alloc::report(std::cout);
+        std::cout << "[fail] 정상 상태 틱에서 힙 할당이 발생했습니다.\n";
+        return 1;
+    }
+    std::cout << "[ok] 정상 상태 틱은 할당 없이 동작합니다.\n";
+
+    // Episode churn: a warmed-up batch hands every new episode a lane whose
+    // state, ring bits and timer slots are reused, so starting and retiring
+    // short episodes must not reach the heap either.
+    struct FullThrottle final : sim::BatchDriver {
+        void started(std::size_t, std::uint32_t, const sim::FlightState &, const sim::Course &,
+                     const std::uint64_t *) override {}
+        sim::Input act(std::size_t, const sim::FlightState &, const sim::Course &, const std::uint64_t *,
+                       std::size_t) override {
+            return {sim::kMaxThrottleDelta, 0.0, 0.0, 0.0};
+        }
+        bool stepped(std::size_t, const sim::FlightState &, const sim::Course &, const std::uint64_t *) override {
+            return true;
+        }
+        void finished(std::size_t, std::uint32_t, const sim::FlightState &) override {}
+        void moved(std::size_t, std::size_t) override {}
+    };
+    constexpr int kEpisodes = 100000;
+    constexpr int kRound = 64;  // episodes queued per run, so the queue keeps its capacity
+    const std::shared_ptr<const sim::Course> courses[] = {sim::Course::generate(6, 1u), sim::Course::generate(64, 2u)};
+    sim::BatchSimulator batch(16, 8, dt);
+    FullThrottle driver;
+    auto round = [&] {
+        for (int e = 0; e < kRound; ++e) {
+            batch.enqueue({courses[e % 2], static_cast<std::uint32_t>(e), nullptr});
+        }
+        batch.run(driver);
+    };
+    round();
+    const std::uint64_t episodeBefore = sim::alloc::totalAllocations();
+    {
+        sim::alloc::NoAllocScope noAlloc;
+        for (int e = 0; e < kEpisodes; e += kRound) {
+            round();
+        }
+    }
+    const std::uint64_t episodeAllocations = sim::alloc::totalAllocations() - episodeBefore;
+    std::cout << "에피소드 검사: 배치에서 " << batch.stats().episodes - kRound << "개 에피소드 동안 힙 할당 "
+              << episodeAllocations << "회\n";
+    if (episodeAllocations != 0) {
+        std::cout << "[fail] 에피소드 시작/종료가 힙을 사용합니다.\n";
+        return 1;
+    }
+    std::cout << "[ok] 배치 레인은 에피소드가 바뀌어도 할당 없이 재사용됩니다.\n";
+    return 0;
+}
+
+// Flies the zero autopilot; enough per-lane work to make the batch memory-bound.
+class CruiseDriver final : public sim::BatchDriver {
+  public:
+    explicit CruiseDriver(const double *params) : controller_(params) {}
+
+    void started(std::size_t, std::uint32_t, const sim::FlightState &, const sim::Course &,
+                 const std::uint64_t *) override {}
+    sim::Input act(std::size_t, const sim::FlightState &state, const sim::Course &course,
+                   const std::uint64_t *passed, std::size_t) override {
+        return controller_.act(sim::observe(state, course, passed));
+    }
+    bool stepped(std::size_t, const sim::FlightState &, const sim::Course &, const std::uint64_t *) override {
+        return true;
+    }
+    void finished(std::size_t, std::uint32_t, const sim::FlightState &) override {}
+    void moved(std::size_t, std::size_t) override {}
+
+  private:
+    sim::LinearController controller_;
+};
+
+// Batch throughput at doubling thread counts, unpinned against pinned with
+// first-touch lane arrays, so cross-node traffic shows up as the gap between
+// the two columns.
+int runNumaBenchmark(const Options &options) {
+    constexpr std::size_t kLanes = 8192;
+    constexpr std::size_t kEpisodesPerWorker = 2 * kLanes;
+    constexpr std::size_t kSteps = 200;
+    const std::shared_ptr<const sim::Course> course = sim::Course::generate(6, 1u);
+    const std::vector<double> params(sim::LinearController::kParameterCount, 0.0);
+
+    const std::vector<sim::numa::Node> &nodes = sim::numa::topology();
+    std::size_t cpuCount = 0;
+    std::cout << "NUMA 노드 " << nodes.size() << "개:";
+    for (const sim::numa::Node &node : nodes) {
+        std::cout << " node" << node.id << "(CPU " << node.cpus.size() << ")";
+        cpuCount += node.cpus.size();
+    }
+    const unsigned int maxThreads =
+        options.es.threads > 0 ? options.es.threads : static_cast<unsigned int>(cpuCount);
+    std::cout << "\n워커당 레인 " << kLanes << ", 에피소드 " << kEpisodesPerWorker << ", 스텝 " << kSteps << "\n";
+
+    auto measure = [&](unsigned int threadCount, bool pinned) {
+        const std::vector<sim::numa::WorkerSlot> slots = sim::numa::placeWorkers(nodes, threadCount);
+        std::function<void(unsigned int)> pinPoolThread;
+        if (pinned) {
+            pinPoolThread = [&slots](unsigned int index) { sim::numa::pinCurrentThread(slots[index].cpu); };
+        }
+        sim::JobSystem jobs(threadCount, pinPoolThread);
+        const sim::numa::PinScope pin(pinned ? slots[0].cpu : -1);
+
+        // One coarse job per thread; each builds its batch where it runs.
+        std::atomic<std::uint64_t> laneSteps{0};
+        const auto start = std::chrono::steady_clock::now();
+        jobs.parallelFor(0, threadCount, 1, [&](std::size_t, std::size_t) {
+            sim::BatchSimulator batch(kLanes, kSteps, 0.1);
+            CruiseDriver driver(params.data());
+            for (std::size_t e = 0; e < kEpisodesPerWorker; ++e) {
+                batch.enqueue({course, static_cast<std::uint32_t>(e), nullptr});
+            }
+            batch.run(driver);
+            laneSteps += batch.stats().laneSteps;
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(laneSteps.load()) / seconds / 1e6;
+    };
+
+    // Hangul is two columns wide on a terminal, so the header is laid out by hand.
+    std::cout << "스레드  비고정 M스텝/s  고정 M스텝/s    배율\n" << std::fixed << std::setprecision(2);
+    for (unsigned int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        const double unpinned = measure(threads, false);
+        const double pinned = measure(threads, true);
+        std::cout << std::setw(6) << threads << std::setw(16) << unpinned << std::setw(14) << pinned << std::setw(7)
+                  << pinned / unpinned << "x\n";
+        if (threads >= maxThreads) {
+            break;
+        }
+    }
+    return 0;
+}
+
+#if SIM_HAS_COROUTINES
+// Demo mission for --script-bench. The aircraft cannot hold altitude much
+// below ~300 m/s, so it covers a ring spacing in about a second and cannot
+// swing 100+ m sideways in that time: rather than chase every ring it flies
+// at the first of the next few whose offset it can still correct, and throttles
+// down once no ring is left ahead.
+sim::ControllerScript demoMission(sim::Pilot &pilot, std::uint32_t) {
+    // Mirrors the constants in physics::integrate.
+    constexpr double kMass = 750.0;
+    constexpr double kThrust = 26000.0;
+    constexpr double kDrag = 0.04;
+    constexpr double kWeight = kMass * 9.81;
+    constexpr double kCruise = 300.0;     // m/s, commanded along the line to the ring
+    constexpr double kGain = 0.5;         // 1/s, velocity error to acceleration
+    constexpr double kEasy = 3.0;         // m/s^2 of correction that counts as reachable
+    constexpr std::size_t kLookahead = 16;
+    auto limit = [](double value, double max) { return std::clamp(value, -max, max); };
+
+    // Acceleration needed to reach ring i on the current velocity, by the
+    // time the aircraft arrives at its depth; negative if it is behind.
+    auto correction = [&](std::size_t i) {
+        const sim::FlightState &state = pilot.state();
+        const sim::Vec3 offset = pilot.course().ring(i).position - state.position;
+        const double t = offset.z / std::max(state.velocity.z, 1.0);
+        if (t <= 0.05) {
+            return -1.0;
+        }
+        const double ax = (offset.x - state.velocity.x * t) / (t * t);
+        const double ay = (offset.y - state.velocity.y * t) / (t * t);
+        return std::sqrt(ax * ax + ay * ay);
+    };
+
+    for (std::size_t next = pilot.nextRing(); next != sim::kNoRing; next = pilot.nextRing()) {
+        std::size_t target = next;
+        double best = std::numeric_limits<double>::infinity();
+        for (std::size_t i = next; i < std::min(pilot.course().size(), next + kLookahead); ++i) {
+            const double need = correction(i);
+            if (need >= 0.0 && need < best) {
+                best = need;
+                target = i;
+            }
+            if (need >= 0.0 && need < kEasy) {
+                break;
+            }
+        }
+
+        // Point the thrust along the force that turns the velocity toward
+        // the ring while carrying the weight. Thrust cannot brake, so the
+        // force never points backwards.
+        const sim::FlightState &state = pilot.state();
+        const sim::Vec3 wanted = sim::normalize(pilot.course().ring(target).position - state.position) * kCruise;
+        sim::Vec3 force = (wanted - state.velocity) * (kMass * kGain) + sim::Vec3{0.0, kWeight, 0.0} +
+                          state.velocity * (kDrag * sim::length(state.velocity));
+        force.z = std::max(force.z, 0.3 * kWeight);
+        const double yaw = std::atan2(force.x, force.z);
+        // Positive pitch is nose-down.
+        const double pitch = -std::atan2(force.y, std::hypot(force.x, force.z));
+        const double throttle = std::min(sim::length(force) / kThrust, 1.0);
+        pilot.command().yawDelta = limit(std::remainder(yaw - state.yaw, 2.0 * M_PI), sim::kMaxYawDelta);
+        pilot.command().pitchDelta = limit(pitch - state.pitch, sim::kMaxPitchDelta);
+        pilot.command().throttleDelta = limit(throttle - state.throttle, sim::kMaxThrottleDelta);
+        pilot.command().rollDelta = limit(-state.roll, sim::kMaxRollDelta);
+        co_await pilot.nextTick();
+    }
+
+    while (pilot.state().throttle > 0.15 || std::abs(pilot.state().roll) > 1.0 * sim::kDegToRad) {
+        pilot.command().throttleDelta = -sim::kMaxThrottleDelta;
+        pilot.command().rollDelta = limit(-pilot.state().roll, sim::kMaxRollDelta);
+        co_await pilot.nextTick();
+    }
+}
+
+// Flies N scripted aircraft in one batch, two episodes each, after a warm-up
+// round that fills the frame pool; the measured round must not touch the heap.
+int runScriptBenchmark(const Options &options) {
+    constexpr std::size_t kSteps = 600;
+    const std::size_t aircraft = options.scriptBenchAircraft;
+    const std::shared_ptr<const sim::Course> course = sim::Course::generate(32, 1u);
+
+    sim::BatchSimulator batch(aircraft, kSteps, 0.1);
+    sim::ScriptDriver driver(aircraft, &demoMission);
+    auto round = [&](sim::BatchDriver &pilots) {
+        for (std::size_t e = 0; e < 2 * aircraft; ++e) {
+            batch.enqueue({course, static_cast<std::uint32_t>(e), nullptr});
+        }
+        const std::uint64_t stepsBefore = batch.stats().laneSteps;
+        const std::uint64_t allocationsBefore = sim::alloc::totalAllocations();
+        const auto start = std::chrono::steady_clock::now();
+        batch.run(pilots);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const std::uint64_t steps = batch.stats().laneSteps - stepsBefore;
+        return std::make_tuple(seconds * 1e9 / static_cast<double>(steps), steps,
+                               sim::alloc::totalAllocations() - allocationsBefore);
+    };
+
+    round(driver);
+    const std::uint64_t warmEpisodes = driver.episodes();
+    const std::int64_t warmScore = driver.totalScore();
+    const auto [scriptNs, steps, allocations] = round(driver);
+    const std::vector<double> params(sim::LinearController::kParameterCount, 0.0);
+    CruiseDriver cruise(params.data());
+    const double cruiseNs = std::get<0>(round(cruise));
+
+    const std::uint64_t episodes = driver.episodes() - warmEpisodes;
+    std::cout << std::fixed << std::setprecision(1) << "스크립트 기체 " << aircraft << "대, 에피소드 " << episodes
+              << ", 스텝 " << steps << "\n"
+              << "기체-틱당 " << scriptNs << "ns (선형 제어기 " << cruiseNs << "ns), 평균 점수 "
+              << static_cast<double>(driver.totalScore() - warmScore) / static_cast<double>(episodes) << "\n"
+              << "측정 구간 힙 할당 " << allocations << "회\n";
+    if (allocations != 0) {
+        std::cout << "[fail] 코루틴 프레임이 힙에서 할당되었습니다.\n";
+        return 1;
+    }
+    std::cout << "[ok] 코루틴 프레임은 풀에서 재사용됩니다.\n";
+    return 0;
+}
+#else
+int runScriptBenchmark(const Options &) {
+    std::cerr << "[error] 이 빌드는 코루틴 스크립트를 지원하지 않습니다. -DFLIGHTSIM_COROUTINES=ON 으로 빌드하세요.\n";
+    return 1;
+}
+#endif
+
+// The same plugin called once per aircraft, to show what batching saves.
+class PerAircraftPluginDriver final : public sim::PluginDriver {
+  public:
+    using sim::PluginDriver::PluginDriver;
+    bool batched() const override { return false; }
+};
+
+// Flies the plugin on generated (or scenario) courses, once with a single
+// control call per tick for the whole batch and once per aircraft.
+int runPluginEvaluation(const Options &options, const sim::ControllerPlugin &plugin) {
+    const std::size_t lanes = options.es.batchLanes;
+    const std::size_t episodes = 16 * lanes;
+
+    auto fly = [&](sim::PluginDriver &driver) {
+        sim::BatchSimulator batch(lanes, options.es.stepsPerEpisode, options.es.dt, options.es.storage);
+        for (std::size_t e = 0; e < episodes; ++e) {
+            const std::uint64_t seed = options.es.seed + e;
+            batch.enqueue({options.es.scenario ? options.es.scenario->course(seed)
+                                               : sim::Course::generate(options.es.ringCount, seed),
+                           static_cast<std::uint32_t>(e), options.es.scenario});
+        }
+        const auto start = std::chrono::steady_clock::now();
+        batch.run(driver);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::make_pair(seconds * 1e9 / static_cast<double>(batch.stats().laneSteps), batch.stats().ticks);
+    };
+
+    sim::PluginDriver batched(plugin, lanes);
+    const auto [batchedNs, ticks] = fly(batched);
+    PerAircraftPluginDriver single(plugin, lanes);
+    const double singleNs = fly(single).first;
+
+    std::cout << std::fixed << std::setprecision(2) << "플러그인 " << plugin.name() << ": 에피소드 "
+              << batched.episodes() << ", 평균 점수 "
+              << static_cast<double>(batched.totalScore()) / static_cast<double>(batched.episodes()) << "\n"
+              << "배치 호출 " << batched.calls() << "회 (틱 " << ticks << "), 호출당 기체 "
+              << static_cast<double>(batched.aircraftSteps()) / static_cast<double>(batched.calls()) << "대\n"
+              << std::setprecision(1) << "기체-틱당 " << batchedNs << "ns (기체별 호출 " << singleNs << "ns, 호출 "
+              << single.calls() << "회)\n";
+    if (single.totalScore() != batched.totalScore()) {
+        std::cout << "[fail] 배치 호출과 기체별 호출의 결과가 다릅니다.\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Generates one large course serially and on the job system and checks that
+// both produce the same rings.
+int runCourseBenchmark(const Options &options) {
+    constexpr std::uint64_t kSeed = 7;
+    const std::size_t rings = options.courseBenchRings;
+
+    auto checksum = [](const sim::Course &course) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < course.size(); ++i) {
+            sum += course.x()[i] * static_cast<double>(i % 97 + 1) + course.y()[i];
+        }
+        return sum;
+    };
+    auto timed = [&](sim::JobSystem *jobs) {
+        const auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<const sim::Course> course = sim::Course::generate(rings, kSeed, jobs);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::make_pair(std::move(course), seconds);
+    };
+
+    const auto [serial, serialSeconds] = timed(nullptr);
+    sim::JobSystem jobs(options.es.threads);
+    const auto [parallel, parallelSeconds] = timed(&jobs);
+
+    const bool same = checksum(*serial) == checksum(*parallel) &&
+                      std::equal(serial->z(), serial->z() + rings, parallel->z());
+    std::cout << std::fixed << std::setprecision(3) << "링 " << rings << "개 생성: 단일 스레드 " << serialSeconds
+              << "s, 스레드 " << jobs.threadCount() << "개 " << parallelSeconds << "s ("
+              << std::setprecision(2) << serialSeconds / parallelSeconds << "x)\n";
+    if (!same) {
+        std::cout << "[fail] 스레드 수에 따라 코스가 달라졌습니다.\n";
+        return 1;
+    }
+    std::cout << "[ok] 두 코스가 동일합니다.\n";
+    return 0;
+}
+
+int runTraining(const Options &options) {
+    sim::alloc::TagScope tag(sim::alloc::kTraining);
+    sim::EsTrainer trainer(options.es);
+    if (options.es.scenario) {
+        std::cout << "시나리오: " << options.es.scenario->name() << "\n";
+    }
+    std::cout << "ES 학습: 세대 " << options.trainIterations << ", 개체 " << options.es.pairs * 2 << ", 에피소드 "
+              << options.es.episodesPerCandidate << ", 기체 상태 "
+              << (options.es.storage == sim::StateStorage::kCompact ? sizeof(sim::CompactFlightState)
+                                                                     : sizeof(sim::FlightState))
+              << "B\n";
+
+    for (std::size_t i = 0; i < options.trainIterations; ++i) {
+        const sim::EsIterationStats stats = trainer.iterate();
+        std::cout << std::fixed << std::setprecision(2) << "[세대 " << stats.iteration << "] 평균 적합도 "
+                  << stats.meanFitness << "  최고 " << stats.bestFitness << "  (" << stats.seconds << "s, 레인 활용률 "
+                  << stats.laneUtilization * 100.0 << "%)\n";
+    }
+    std::cout << "최종 파라미터 평가: " << trainer.evaluateCurrent() << "\n";
+
+    std::ofstream out(options.trainOutput);
+    if (!out) {
+        std::cerr << "[error] 파라미터를 저장할 수 없습니다: " << options.trainOutput << "\n";
+        return 1;
+    }
+    out << std::setprecision(17);
+    for (const double p : trainer.parameters()) {
+        out << p << "\n";
+    }
+    std::cout << "파라미터 저장: " << options.trainOutput << "\n";
+    return 0;
+}
+
+int printDatasetInfo(const std::string &directory) {
+    const sim::DatasetReader reader(directory);
+    if (!reader.valid()) {
+        std::cerr << "[error] 데이터셋을 열 수 없습니다: " << directory << "\n";
+        return 1;
+    }
+    std::size_t episodes = 0;
+    for (std::size_t c = 0; c < reader.chunkCount(); ++c) {
+        episodes = std::max<std::size_t>(episodes, reader.entry(c).episode + 1);
+    }
+    std::cout << "데이터셋 " << directory << ": 청크 " << reader.chunkCount() << ", 샘플 " << reader.totalSamples()
+              << ", 에피소드 " << episodes << "\n";
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (!options.tracePath.empty()) {
+        sim::trace::Recorder::instance().enable(static_cast<std::uint32_t>(options.traceSampleEvery));
+    }
+    if (options.perf) {
+        sim::perf::Profiler::instance().enable();
+    }
+    // A resumed session takes its scenario and time limit from the journal.
+    std::unique_ptr<sim::journal::Recovery> recovery;
+    if (!options.resumePath.empty()) {
+        if (!options.journalPath.empty() || !options.scenarioPath.empty() || options.timeLimitSeconds > 0) {
+            std::cerr << "[error] --resume 은 --journal, --scenario, --time-limit 과 함께 쓸 수 없습니다 "
+                         "(저널에 기록된 값을 씁니다)\n";
+            return 2;
+        }
+        recovery = std::make_unique<sim::journal::Recovery>();
+        std::string error;
+        if (!sim::journal::recover(options.resumePath, *recovery, error)) {
+            std::cerr << "[error] " << error << "\n";
+            return 1;
+        }
+        options.scenarioPath = recovery->session.scenarioPath;
+        options.timeLimitSeconds = static_cast<std::size_t>(recovery->session.timeLimitSeconds);
+    }
+    std::shared_ptr<const sim::Scenario> scenario;
+    if (!options.scenarioPath.empty()) {
+        auto compiled = std::make_shared<sim::Scenario>();
+        std::string error;
+        if (!sim::Scenario::load(options.scenarioPath, *compiled, error)) {
+            std::cerr << "[error] 시나리오를 컴파일할 수 없습니다: " << error << "\n";
+            return 1;
+        }
+        scenario = std::move(compiled);
+        options.es.scenario = scenario;
+    }
+    if (options.es.storage == sim::StateStorage::kCompact) {
+        const auto [shallowest, deepest] =
+            scenario ? scenario->courseDepths()
+                     : std::make_pair(sim::Course::kSpacing,
+                                      sim::Course::kSpacing * static_cast<double>(options.es.ringCount));
+        const double start = scenario ? scenario->initialState().position.z : 0.0;
+        if (!sim::CompactFlightState::covers(std::min(start, shallowest), deepest)) {
+            std::cerr << "[error] --compact-state 는 z 0~" << sim::CompactFlightState::kMaxDepth / 1000.0
+                      << "km 안의 코스만 표현할 수 있습니다 (이 코스: " << shallowest / 1000.0 << "~"
+                      << deepest / 1000.0 << "km)\n";
+            return 2;
+        }
+    }
+    sim::ControllerPlugin plugin;
+    if (!options.pluginPath.empty()) {
+        std::string error;
+        if (!sim::ControllerPlugin::load(options.pluginPath, plugin, error)) {
+            std::cerr << "[error] 플러그인을 불러올 수 없습니다: " << error << "\n";
+            return 1;
+        }
+        return runPluginEvaluation(options, plugin);
+    }
+    if (options.scenarioDump) {
+        if (!scenario) {
+            std::cerr << "[error] --scenario-dump 에는 --scenario <파일> 이 필요합니다\n";
+            return 2;
+        }
+        std::cout << "시나리오 " << scenario->name() << ": 명령 " << scenario->code().size() << "개 ("
+                  << scenario->code().size() * sizeof(sim::Scenario::Instruction) << "B)\n";
+        scenario->disassemble(std::cout);
+        return 0;
+    }
+    if (options.allocCheck) {
+        return runAllocationCheck();
+    }
+    if (options.numaBench) {
+        return runNumaBenchmark(options);
+    }
+    if (options.courseBenchRings > 0) {
+        return runCourseBenchmark(options);
+    }
+    if (options.scriptBenchAircraft > 0) {
+        return runScriptBenchmark(options);
+    }
+    if (options.train) {
+        const int status = runTraining(options);
+        if (!options.tracePath.empty()) {
+            dumpTrace(options.tracePath);
+        }
+        if (options.perf) {
+            sim::perf::Profiler::instance().report(std::cout);
+        }
+        if (options.allocStats) {
+            sim::alloc::report(std::cout);
+        }
+        return status;
+    }
+    if (!options.datasetInfo.empty()) {
+        return printDatasetInfo(options.datasetInfo);
+    }
+
     constexpr double dt = 0.1;  // seconds per tick
-    sim::Simulator simulator(6);
+    constexpr int kJournalCheckpointTicks = 50;
+    const auto seed = recovery ? recovery->session.seed : static_cast<unsigned int>(std::time(nullptr));
+    const std::size_t ringCount = recovery ? recovery->session.ringCount : 6;
+    sim::Simulator simulator = scenario ? sim::Simulator(scenario->course(seed), scenario->initialState())
+                                        : sim::Simulator(ringCount, seed);
+    std::unique_ptr<sim::ScenarioRunner> runner;
+    if (scenario) {
+        runner = std::make_unique<sim::ScenarioRunner>(scenario);
+        runner->attach(simulator);
+    }
 
     std::cout << "간단한 텍스트 기반 비행 시뮬레이터 (C++)\n";
     std::cout << "목표: 연료를 아껴가며 링을 통과해 점수를 얻으세요.\n";
     printHelp();
 
+    std::unique_ptr<sim::DatasetWriter> demos;
+    if (!options.demoDirectory.empty()) {
+        demos = std::make_unique<sim::DatasetWriter>(options.demoDirectory);
+        if (!demos->ok()) {
+            std::cerr << "[error] 시연 데이터셋을 열 수 없습니다: " << options.demoDirectory << "\n";
+            return 1;
+        }
+        std::cout << "시연 기록 중: " << options.demoDirectory << " (에피소드 " << demos->episode() << ")\n";
+    }
+
+    std::unique_ptr<sim::TelemetryWriter> telemetry;
+    if (!options.telemetryPath.empty()) {
+        telemetry = std::make_unique<sim::TelemetryWriter>(options.telemetryPath, options.telemetryCompress, 4096,
+                                                           options.telemetryIo);
+        if (!telemetry->ok()) {
+            std::cerr << "[error] 텔레메트리 파일을 열 수 없습니다: " << options.telemetryPath << "\n";
+            return 1;
+        }
+    }
+
+    sim::MacroLibrary macros;
+    {
+        sim::alloc::TagScope tag(sim::alloc::kIo);
+        std::string error;
+        if (!macros.load(options.macroPath, error)) {
+            std::cerr << "[error] " << error << "\n";
+            return 1;
+        }
+    }
+    if (!macros.macros().empty()) {
+        std::cout << "매크로 " << macros.macros().size() << "개 (" << options.macroPath << "):";
+        for (const sim::MacroLibrary::Macro &m : macros.macros()) {
+            std::cout << " " << m.name;
+        }
+        std::cout << "\n";
+    }
+    auto saveMacros = [&] {
+        sim::alloc::TagScope tag(sim::alloc::kIo);
+        if (!macros.save(options.macroPath)) {
+            std::cerr << "[error] 매크로 파일을 저장할 수 없습니다: " << options.macroPath << "\n";
+        }
+    };
+
     int tick = 0;
     std::string line;
+    sim::InputLatencyTracker latency;
+    HudEventLog events;
+    simulator.subscribe(&events);
+    if (recovery && recovery->haveCheckpoint) {
+        const sim::journal::Checkpoint &checkpoint = recovery->checkpoint;
+        if (checkpoint.passedWords != (simulator.course().size() + 63) / 64) {
+            std::cerr << "[error] 저널 체크포인트가 코스와 맞지 않습니다: " << options.resumePath << "\n";
+            return 1;
+        }
+        simulator.restore(checkpoint.state, recovery->passed.data(), checkpoint.tick, checkpoint.wind);
+        if (runner) {
+            runner->restore(checkpoint.scenario);
+        }
+    }
+    TimeLimit timeLimit;
+    if (options.timeLimitSeconds > 0) {
+        const auto limit = static_cast<std::uint64_t>(std::llround(options.timeLimitSeconds / dt));
+        simulator.subscribe(&timeLimit);
+        simulator.schedule(limit > simulator.tick() ? limit - simulator.tick() : 1, TimeLimit::kTag);
+        std::cout << "제한 시간: " << options.timeLimitSeconds << "초\n";
+    }
+
+    // Resume: the checkpoint put the simulator at firstTailTick; the inputs
+    // flown after it bring it back to where the journal ends.
+    std::unique_ptr<sim::JournalWriter> journal;
+    if (recovery) {
+        for (const sim::Input &input : recovery->tail) {
+            simulator.step(input, dt);
+        }
+        tick = static_cast<int>(simulator.tick());
+        std::cout << "세션 복구: " << options.resumePath << " (틱 " << recovery->firstTailTick
+                  << " 체크포인트 + 입력 " << recovery->tail.size() << "틱 재생 -> 틱 " << tick << ")\n";
+        if (recovery->droppedBytes > 0) {
+            std::cout << "저널 끝의 손상된 " << recovery->droppedBytes << "바이트를 버렸습니다.\n";
+        }
+        journal = std::make_unique<sim::JournalWriter>(options.resumePath, recovery->validBytes);
+        options.journalPath = options.resumePath;
+    } else if (!options.journalPath.empty()) {
+        const std::string scenarioPath =
+            options.scenarioPath.empty() ? std::string() : std::filesystem::absolute(options.scenarioPath).string();
+        journal = std::make_unique<sim::JournalWriter>(
+            options.journalPath,
+            sim::journal::Session{seed, static_cast<std::uint32_t>(ringCount),
+                                  static_cast<double>(options.timeLimitSeconds), scenarioPath});
+    }
+    auto scenarioState = [&] { return runner ? runner->state() : sim::ScenarioState{}; };
+    if (journal) {
+        if (!journal->ok()) {
+            std::cerr << "[error] 저널 파일을 열 수 없습니다: " << options.journalPath << "\n";
+            return 1;
+        }
+        journal->checkpoint(simulator, scenarioState());
+    }
 
-    while (simulator.state().fuel > 0.0) {
-        printHUD(simulator, tick, dt);
-        std::cout << "명령 입력: ";
-        std::getline(std::cin, line);
+    // Readers map the ring themselves (flightsim_watch); publishing is a few
+    // stores per tick.
+    std::unique_ptr<sim::ShmPublisher> shm;
+    if (!options.shmName.empty()) {
+        shm = std::make_unique<sim::ShmPublisher>(options.shmName);
+        if (!shm->ok()) {
+            std::cerr << "[error] 공유 메모리를 만들 수 없습니다: " << options.shmName << "\n";
+            return 1;
+        }
+        shm->publish(sim::shm::toRecord(simulator.tick(), simulator.state(), simulator.remainingRings()));
+        std::cout << "공유 메모리 발행: " << options.shmName << " (flightsim_watch " << options.shmName << ")\n";
+    }
+
+    if (scenario) {
+        std::cout << "시나리오: " << scenario->name() << "\n";
+    }
+    auto flying = [&] {
+        return simulator.state().fuel > 0.0 && !timeLimit.expired() &&
+               (!runner || runner->outcome() == sim::ScenarioOutcome::kRunning);
+    };
+    // Every tick, typed or replayed, goes through here.
+    auto fly = [&](const sim::Input &input) {
+        if (journal) {
+            sim::alloc::TagScope tag(sim::alloc::kIo);
+            journal->input(static_cast<std::uint64_t>(tick), input);
+        }
+        macros.record(input);
+        if (demos) {
+            sim::alloc::TagScope tag(sim::alloc::kDataset);
+            demos->append(sim::observe(simulator), input, static_cast<std::uint32_t>(tick));
+        }
+        simulator.step(input, dt);
+        ++tick;
+        if (journal && tick % kJournalCheckpointTicks == 0) {
+            sim::alloc::TagScope tag(sim::alloc::kIo);
+            journal->checkpoint(simulator, scenarioState());
+        }
+        if (telemetry) {
+            SIM_TRACE_SCOPE("telemetry.record");
+            sim::alloc::TagScope tag(sim::alloc::kTelemetry);
+            telemetry->record(static_cast<std::uint64_t>(tick), simulator.state());
+        }
+        if (shm) {
+            shm->publish(sim::shm::toRecord(simulator.tick(), simulator.state(), simulator.remainingRings()));
+        }
+    };
+
+    while (flying()) {
+        sim::trace::Recorder::instance().beginTick(static_cast<std::uint64_t>(tick));
+        printHUD(std::cout, simulator, tick, dt, latency, events);
+        if (macros.recording()) {
+            std::cout << "[REC] " << macros.open().name << " (" << macros.open().inputs.size() << "틱)\n";
+        }
+        std::cout << "명령 입력: " << std::flush;
+        latency.frameDisplayed();
+        {
+            SIM_TRACE_SCOPE("io.readInput");
+            sim::alloc::TagScope tag(sim::alloc::kIo);
+            std::getline(std::cin, line);
+        }
+        latency.inputReceived();
         if (!std::cin) {
             break;
         }
@@ -311,15 +1209,114 @@ int main() {
             break;
         }
         if (line == "help") {
+            latency.cancel();
             printHelp();
             continue;
         }
+        if (line == "trace") {
+            latency.cancel();
+            dumpTrace(options.tracePath);
+            continue;
+        }
 
-        const sim::Input input = parseInput(line);
-        simulator.step(input, dt);
-        ++tick;
+        const MacroCommand command = parseMacroCommand(line);
+        if (command.kind != MacroCommand::kNone) {
+            latency.cancel();
+        }
+        switch (command.kind) {
+            case MacroCommand::kNone:
+                fly(parseInput(line));
+                break;
+            case MacroCommand::kInvalid:
+                std::cout << "[error] 사용법: record <이름> | stop | play <이름> [xN] | macros\n";
+                break;
+            case MacroCommand::kRecord:
+                if (macros.recording()) {
+                    std::cout << "[error] 이미 " << macros.open().name << " 을(를) 기록 중입니다. 먼저 stop 하세요.\n";
+                } else if (!macros.startRecording(command.name)) {
+                    std::cout << "[error] 매크로 이름은 공백 없이 1~" << sim::macro::kMaxName << "자여야 합니다.\n";
+                } else {
+                    std::cout << "매크로 기록 시작: " << command.name << " (stop 으로 종료)\n";
+                }
+                break;
+            case MacroCommand::kStop:
+                if (const sim::MacroLibrary::Macro *stored = macros.stopRecording()) {
+                    std::cout << "매크로 저장: " << stored->name << " (" << stored->inputs.size() << "틱)\n";
+                    saveMacros();
+                } else {
+                    std::cout << "[error] 기록 중인 매크로가 없습니다.\n";
+                }
+                break;
+            case MacroCommand::kList:
+                if (macros.macros().empty()) {
+                    std::cout << "저장된 매크로가 없습니다.\n";
+                }
+                for (const sim::MacroLibrary::Macro &m : macros.macros()) {
+                    std::cout << "  " << m.name << " (" << m.inputs.size() << "틱)\n";
+                }
+                break;
+            case MacroCommand::kPlay: {
+                const sim::MacroLibrary::Macro *m = macros.find(command.name);
+                if (m == nullptr) {
+                    std::cout << "[error] 매크로가 없습니다: " << command.name << "\n";
+                    break;
+                }
+                // Replays the stored inputs without parsing; the HUD comes
+                // every `every` ticks and again at the top of the loop.
+                const std::size_t total = m->inputs.size();
+                std::size_t played = 0;
+                while (played < total && flying()) {
+                    fly(m->inputs[played++]);
+                    if (played % command.every == 0 && played < total) {
+                        printHUD(std::cout, simulator, tick, dt, latency, events);
+                    }
+                }
+                std::cout << "매크로 재생: " << command.name << " " << played << "/" << total << "틱\n";
+                break;
+            }
+        }
+    }
+    if (macros.recording()) {
+        const sim::MacroLibrary::Macro *stored = macros.stopRecording();
+        std::cout << "\n기록 중이던 매크로 저장: " << stored->name << " (" << stored->inputs.size() << "틱)";
+        saveMacros();
     }
 
+    if (timeLimit.expired()) {
+        std::cout << "\n제한 시간 종료!";
+    }
+    if (runner && runner->outcome() != sim::ScenarioOutcome::kRunning) {
+        std::cout << (runner->outcome() == sim::ScenarioOutcome::kSucceeded ? "\n시나리오 성공!" : "\n시나리오 실패");
+    }
     std::cout << "\n비행 종료! 최종 점수: " << simulator.state().score << "\n";
+    if (journal) {
+        journal->checkpoint(simulator, scenarioState());
+        if (!journal->flush()) {
+            std::cerr << "[error] 저널을 기록할 수 없습니다: " << options.journalPath << "\n";
+        }
+        const sim::JournalStats stats = journal->stats();
+        std::cout << "저널: 레코드 " << stats.records << "개, " << stats.bytes << "바이트, fsync " << stats.commits
+                  << "회, 최대 커밋 지연 " << std::fixed << std::setprecision(1)
+                  << static_cast<double>(stats.maxCommitDelay.count()) / 1000.0 << "ms (" << options.journalPath
+                  << ")\n";
+    }
+    if (telemetry) {
+        telemetry->flush();
+        std::cout << "텔레메트리: " << telemetry->rowsWritten() << "행 기록, " << telemetry->rowsDropped()
+                  << "행 버림 (" << telemetry->backend() << ")\n";
+        if (!telemetry->ok()) {
+            std::cerr << "[error] 텔레메트리를 기록할 수 없습니다: " << options.telemetryPath << "\n";
+        }
+    }
+    printLatencySummary(latency.histogram());
+    if (!options.tracePath.empty()) {
+        dumpTrace(options.tracePath);
+    }
+    if (options.perf) {
+        sim::perf::Profiler::instance().report(std::cout);
+    }
+    if (options.allocStats) {
+        sim::alloc::report(std::cout);
+    }
     return 0;
 }
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sim {
+namespace numa {
+
+// NUMA placement for batch workers. The topology comes from
+// /sys/devices/system/node, restricted to the CPUs this process may run on;
+// without it (non-Linux, containers hiding sysfs) everything is one node.
+// Memory placement relies on the kernel's first-touch policy: a worker pins
+// itself before it builds its batch, so the lane arrays it value-initialises
+// land on its own node.
+
+struct Node {
+    int id{0};
+    std::vector<int> cpus;
+};
+
+// Parses a sysfs cpulist such as "0-3,8-11,16".
+inline std::vector<int> parseCpuList(const std::string &text) {
+    std::vector<int> cpus;
+    std::istringstream in(text);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        const std::size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception &) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+inline std::vector<Node> discover() {
+    std::vector<Node> nodes;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    if (DIR *dir = opendir("/sys/devices/system/node")) {
+        while (const dirent *entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                continue;
+            }
+            std::ifstream list("/sys/devices/system/node/" + name + "/cpulist");
+            std::string text;
+            std::getline(list, text);
+            Node node;
+            node.id = std::stoi(name.substr(4));
+            for (const int cpu : parseCpuList(text)) {
+                if (!haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.id < b.id; });
+    if (nodes.empty() && haveMask) {
+        Node node;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+#endif
+    if (nodes.empty()) {
+        Node node;
+        const unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int cpu = 0; cpu < count; ++cpu) {
+            node.cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+inline const std::vector<Node> &topology() {
+    static const std::vector<Node> nodes = discover();
+    return nodes;
+}
+
+struct WorkerSlot {
+    std::size_t node{0};  // index into topology()
+    int cpu{0};
+};
+
+// Spreads workers over nodes in contiguous groups (workers 0..k-1 on the first
+// node, and so on), round-robin over each node's CPUs.
+inline std::vector<WorkerSlot> placeWorkers(const std::vector<Node> &nodes, unsigned int workers) {
+    std::vector<WorkerSlot> slots(workers);
+    for (unsigned int w = 0; w < workers; ++w) {
+        const std::size_t node = static_cast<std::size_t>(w) * nodes.size() / workers;
+        const std::size_t first = (node * workers + nodes.size() - 1) / nodes.size();
+        const std::vector<int> &cpus = nodes[node].cpus;
+        slots[w] = {node, cpus[(w - first) % cpus.size()]};
+    }
+    return slots;
+}
+
+// Pins the calling thread to one CPU for good (pool threads).
+inline bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpu, &target);
+    return pthread_setaffinity_np(pthread_self(), sizeof(target), &target) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Pins the calling thread to one CPU for its lifetime and restores the
+// previous affinity on destruction. A failed pin leaves the thread unpinned.
+class PinScope {
+  public:
+    explicit PinScope(int cpu) {
+#if defined(__linux__)
+        if (cpu < 0 || pthread_getaffinity_np(pthread_self(), sizeof(previous_), &previous_) != 0) {
+            return;
+        }
+        pinned_ = pinCurrentThread(cpu);
+#else
+        (void)cpu;
+#endif
+    }
+
+    ~PinScope() {
+#if defined(__linux__)
+        if (pinned_) {
+            pthread_setaffinity_np(pthread_self(), sizeof(previous_), &previous_);
+        }
+#endif
+    }
+
+    PinScope(const PinScope &) = delete;
+    PinScope &operator=(const PinScope &) = delete;
+
+    bool pinned() const { return pinned_; }
+
+  private:
+#if defined(__linux__)
+    cpu_set_t previous_{};
+#endif
+    bool pinned_{false};
+};
+
+}  // namespace numa
+}  // namespace sim
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "trace.hpp"
+
+namespace sim {
+namespace perf {
+
+// Hardware counters around simulation phases. Each thread opens its own
+// perf_event group (cycles leads instructions, cache misses and branch misses)
+// and accumulates into thread-local totals that the report merges. When the
+// kernel refuses the counters (no PMU in a VM, perf_event_paranoid, non-Linux)
+// the profiler still reports call counts and wall time.
+
+enum Phase : std::size_t {
+    kStep,
+    kIntegrate,
+    kCheckRings,
+    kClampToGround,
+    kBatchStep,
+    kPhaseCount
+};
+
+constexpr std::array<const char *, kPhaseCount> kPhaseNames{"step", "integrate", "checkRings", "clampToGround",
+                                                            "batch.step"};
+
+enum Counter : std::size_t { kCycles, kInstructions, kCacheMisses, kBranchMisses, kCounterCount };
+
+struct Reading {
+    std::array<std::uint64_t, kCounterCount> counters{};
+    std::uint64_t ns{0};
+};
+
+class CounterGroup {
+  public:
+    CounterGroup() {
+#if defined(__linux__)
+        const std::uint64_t configs[kCounterCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (std::size_t i = 0; i < kCounterCount; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+            if (fd < 0) {
+                closeAll();
+                return;
+            }
+            fds_[i] = static_cast<int>(fd);
+        }
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        available_ = true;
+#endif
+    }
+
+    ~CounterGroup() { closeAll(); }
+
+    CounterGroup(const CounterGroup &) = delete;
+    CounterGroup &operator=(const CounterGroup &) = delete;
+
+    bool available() const { return available_; }
+
+    Reading read() const {
+        Reading reading;
+        reading.ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#if defined(__linux__)
+        if (available_) {
+            std::uint64_t buffer[1 + kCounterCount] = {};
+            if (::read(fds_[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer))) {
+                for (std::size_t i = 0; i < kCounterCount; ++i) {
+                    reading.counters[i] = buffer[1 + i];
+                }
+            }
+        }
+#endif
+        return reading;
+    }
+
+  private:
+    std::array<int, kCounterCount> fds_{-1, -1, -1, -1};
+    bool available_{false};
+
+    void closeAll() {
+#if defined(__linux__)
+        for (int &fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+#endif
+        available_ = false;
+    }
+};
+
+struct PhaseTotals {
+    std::uint64_t calls{0};
+    std::uint64_t ticks{0};  // aircraft-ticks covered: one per step, one per live lane per batch pass
+    std::uint64_t ns{0};
+    std::array<std::uint64_t, kCounterCount> counters{};
+};
+
+struct ThreadState {
+    CounterGroup group;
+    std::array<PhaseTotals, kPhaseCount> phases{};
+};
+
+class Profiler {
+  public:
+    static Profiler &instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void enable() { enabled_.store(true, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    ThreadState &local() {
+        thread_local ThreadState *state = nullptr;
+        if (state == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.push_back(std::make_unique<ThreadState>());
+            state = threads_.back().get();
+        }
+        return *state;
+    }
+
+    // Per-tick columns are normalised by each phase's own tick count, so the
+    // batch phase reports per lane-tick even when no Simulator::step ran.
+    void report(std::ostream &out) {
+        std::array<PhaseTotals, kPhaseCount> totals{};
+        bool hardware = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto &thread : threads_) {
+                hardware = hardware || thread->group.available();
+                for (std::size_t p = 0; p < kPhaseCount; ++p) {
+                    totals[p].calls += thread->phases[p].calls;
+                    totals[p].ticks += thread->phases[p].ticks;
+                    totals[p].ns += thread->phases[p].ns;
+                    for (std::size_t c = 0; c < kCounterCount; ++c) {
+                        totals[p].counters[c] += thread->phases[p].counters[c];
+                    }
+                }
+            }
+        }
+
+        out << "\n=== 단계별 성능 카운터 ===\n";
+        if (!hardware) {
+            out << "하드웨어 카운터를 사용할 수 없어 호출 수와 경과 시간만 표시합니다"
+                << " (VM/컨테이너 또는 /proc/sys/kernel/perf_event_paranoid 확인).\n";
+        }
+        out << std::left << std::setw(15) << "단계" << std::right << std::setw(10) << "호출" << std::setw(12) << "틱"
+            << std::setw(12) << "ns/호출";
+        if (hardware) {
+            out << std::setw(14) << "cycles/호출" << std::setw(8) << "IPC" << std::setw(14) << "캐시미스/틱"
+                << std::setw(14) << "분기미스/틱";
+        }
+        out << "\n" << std::fixed;
+        for (std::size_t p = 0; p < kPhaseCount; ++p) {
+            const PhaseTotals &t = totals[p];
+            if (t.calls == 0) {
+                continue;
+            }
+            const double calls = static_cast<double>(t.calls);
+            const double perTick = t.ticks > 0 ? 1.0 / static_cast<double>(t.ticks) : 0.0;
+            out << std::left << std::setw(15) << kPhaseNames[p] << std::right << std::setw(10) << t.calls
+                << std::setw(12) << t.ticks << std::setw(12) << std::setprecision(1)
+                << static_cast<double>(t.ns) / calls;
+            if (hardware) {
+                const double cycles = static_cast<double>(t.counters[kCycles]);
+                out << std::setw(14) << cycles / calls << std::setw(8) << std::setprecision(2)
+                    << (cycles > 0.0 ? static_cast<double>(t.counters[kInstructions]) / cycles : 0.0)
+                    << std::setw(14) << static_cast<double>(t.counters[kCacheMisses]) * perTick << std::setw(14)
+                    << static_cast<double>(t.counters[kBranchMisses]) * perTick;
+            }
+            out << "\n";
+        }
+    }
+
+  private:
+    std::atomic<bool> enabled_{false};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadState>> threads_;
+};
+
+// RAII scope adding the counter delta across its lifetime to one phase; ticks
+// is how many aircraft-ticks the scope advances.
+class Scope {
+  public:
+    explicit Scope(Phase phase, std::uint64_t ticks = 1)
+        : state_(Profiler::instance().enabled() ? &Profiler::instance().local() : nullptr) {
+        if (state_ != nullptr) {
+            phase_ = phase;
+            ticks_ = ticks;
+            start_ = state_->group.read();
+        }
+    }
+
+    ~Scope() {
+        if (state_ == nullptr) {
+            return;
+        }
+        const Reading end = state_->group.read();
+        PhaseTotals &totals = state_->phases[phase_];
+        ++totals.calls;
+        totals.ticks += ticks_;
+        totals.ns += end.ns - start_.ns;
+        for (std::size_t c = 0; c < kCounterCount; ++c) {
+            totals.counters[c] += end.counters[c] - start_.counters[c];
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    ThreadState *state_;
+    Phase phase_{kStep};
+    std::uint64_t ticks_{1};
+    Reading start_{};
+};
+
+}  // namespace perf
+}  // namespace sim
+
+#define SIM_PERF_SCOPE(phase) \
+    ::sim::perf::Scope SIM_TRACE_CONCAT(simPerfScope, __LINE__)(::sim::perf::phase)
+#define SIM_PERF_SCOPE_TICKS(phase, ticks) \
+    ::sim::perf::Scope SIM_TRACE_CONCAT(simPerfScope, __LINE__)(::sim::perf::phase, ticks)
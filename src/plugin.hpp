@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define SIM_HAS_DLOPEN 1
+#else
+#define SIM_HAS_DLOPEN 0
+#endif
+
+#include "batch.hpp"
+#include "controller.hpp"
+#include "flightsim_plugin.h"
+#include "simulator.hpp"
+
+namespace sim {
+
+// A third-party autopilot loaded from a shared object at startup; the ABI is
+// in flightsim_plugin.h. The library stays loaded for the object's lifetime.
+class ControllerPlugin {
+  public:
+    ControllerPlugin() = default;
+    ControllerPlugin(ControllerPlugin &&other) noexcept { *this = std::move(other); }
+    ControllerPlugin &operator=(ControllerPlugin &&other) noexcept {
+        if (this != &other) {
+            close();
+            handle_ = std::exchange(other.handle_, nullptr);
+            control_ = std::exchange(other.control_, nullptr);
+            name_ = std::move(other.name_);
+        }
+        return *this;
+    }
+    ControllerPlugin(const ControllerPlugin &) = delete;
+    ControllerPlugin &operator=(const ControllerPlugin &) = delete;
+    ~ControllerPlugin() { close(); }
+
+    static bool load(const std::string &path, ControllerPlugin &out, std::string &error) {
+#if SIM_HAS_DLOPEN
+        void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr) {
+            const char *reason = dlerror();
+            error = reason != nullptr ? reason : "dlopen 실패: " + path;
+            return false;
+        }
+        auto abi = reinterpret_cast<flightsim_plugin_abi_fn>(dlsym(handle, "flightsim_plugin_abi"));
+        auto control = reinterpret_cast<flightsim_control_fn>(dlsym(handle, "flightsim_control"));
+        auto name = reinterpret_cast<flightsim_plugin_name_fn>(dlsym(handle, "flightsim_plugin_name"));
+        if (abi == nullptr || control == nullptr) {
+            error = path + ": flightsim_plugin_abi 또는 flightsim_control 심볼이 없습니다";
+            dlclose(handle);
+            return false;
+        }
+        if (abi() != FLIGHTSIM_PLUGIN_ABI) {
+            error = path + ": ABI 버전이 맞지 않습니다 (플러그인 " + std::to_string(abi()) + ", flightsim " +
+                    std::to_string(FLIGHTSIM_PLUGIN_ABI) + ")";
+            dlclose(handle);
+            return false;
+        }
+        ControllerPlugin plugin;
+        plugin.handle_ = handle;
+        plugin.control_ = control;
+        const char *label = name != nullptr ? name() : nullptr;
+        plugin.name_ = label != nullptr ? label : path;
+        out = std::move(plugin);
+        return true;
+#else
+        error = "이 플랫폼은 플러그인(dlopen)을 지원하지 않습니다: " + path;
+        return false;
+#endif
+    }
+
+    bool loaded() const { return control_ != nullptr; }
+    const std::string &name() const { return name_; }
+
+    void control(const FlightsimState *states, FlightsimInput *out, std::size_t n) const { control_(states, out, n); }
+
+  private:
+    void *handle_{nullptr};
+    flightsim_control_fn control_{nullptr};
+    std::string name_;
+
+    void close() {
+#if SIM_HAS_DLOPEN
+        if (handle_ != nullptr) {
+            dlclose(handle_);
+        }
+#endif
+        handle_ = nullptr;
+        control_ = nullptr;
+    }
+};
+
+inline FlightsimState toPluginState(const FlightState &state, const Course &course, const std::uint64_t *passed,
+                                    std::size_t ringsLeft, std::uint32_t id) {
+    FlightsimState out{};
+    out.position[0] = state.position.x;
+    out.position[1] = state.position.y;
+    out.position[2] = state.position.z;
+    out.velocity[0] = state.velocity.x;
+    out.velocity[1] = state.velocity.y;
+    out.velocity[2] = state.velocity.z;
+    out.yaw = state.yaw;
+    out.pitch = state.pitch;
+    out.roll = state.roll;
+    out.throttle = state.throttle;
+    out.fuel = state.fuel;
+    const std::size_t ring = nextRing(state, course, passed);
+    if (ring != kNoRing) {
+        out.ring[0] = course.x()[ring];
+        out.ring[1] = course.y()[ring];
+        out.ring[2] = course.z()[ring];
+        out.ring[3] = course.radius()[ring];
+    }
+    out.id = id;
+    out.rings_left = static_cast<std::uint32_t>(ringsLeft);
+    return out;
+}
+
+// Plugins get the same per-tick authority as the built-in controllers.
+inline Input fromPluginInput(const FlightsimInput &in) {
+    auto limit = [](double value, double max) { return std::isfinite(value) ? std::clamp(value, -max, max) : 0.0; };
+    return {limit(in.throttle_delta, kMaxThrottleDelta), limit(in.pitch_delta, kMaxPitchDelta),
+            limit(in.yaw_delta, kMaxYawDelta), limit(in.roll_delta, kMaxRollDelta)};
+}
+
+// Flies a batch with a plugin: one flightsim_control call per tick covers
+// every live lane. The marshalling buffers are sized once for the batch.
+class PluginDriver : public BatchDriver {
+  public:
+    PluginDriver(const ControllerPlugin &plugin, std::size_t lanes)
+        : plugin_(plugin), states_(lanes), commands_(lanes), tags_(lanes, 0) {}
+
+    void started(std::size_t lane, std::uint32_t tag, const FlightState &, const Course &,
+                 const std::uint64_t *) override {
+        tags_[lane] = tag;
+    }
+
+    Input act(std::size_t lane, const FlightState &state, const Course &course, const std::uint64_t *passed,
+              std::size_t ringsLeft) override {
+        const LaneView view{lane, &state, &course, passed, ringsLeft};
+        Input input;
+        actAll(&view, 1, &input);
+        return input;
+    }
+
+    bool stepped(std::size_t, const FlightState &, const Course &, const std::uint64_t *) override { return true; }
+
+    void finished(std::size_t, std::uint32_t, const FlightState &state) override {
+        ++episodes_;
+        score_ += state.score;
+    }
+
+    void moved(std::size_t from, std::size_t to) override { tags_[to] = tags_[from]; }
+
+    bool batched() const override { return true; }
+
+    void actAll(const LaneView *lanes, std::size_t count, Input *out) override {
+        for (std::size_t i = 0; i < count; ++i) {
+            const LaneView &view = lanes[i];
+            states_[i] = toPluginState(*view.state, *view.course, view.passed, view.ringsLeft, tags_[view.lane]);
+        }
+        plugin_.control(states_.data(), commands_.data(), count);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = fromPluginInput(commands_[i]);
+        }
+        ++calls_;
+        aircraft_ += count;
+    }
+
+    std::uint64_t calls() const { return calls_; }
+    std::uint64_t aircraftSteps() const { return aircraft_; }
+    std::uint64_t episodes() const { return episodes_; }
+    std::int64_t totalScore() const { return score_; }
+
+  private:
+    const ControllerPlugin &plugin_;
+    std::vector<FlightsimState> states_;
+    std::vector<FlightsimInput> commands_;
+    std::vector<std::uint32_t> tags_;
+    std::uint64_t calls_{0};
+    std::uint64_t aircraft_{0};
+    std::uint64_t episodes_{0};
+    std::int64_t score_{0};
+};
+
+}  // namespace sim
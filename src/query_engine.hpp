@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "telemetry.hpp"
+#include "telemetry_query.hpp"
+
+namespace sim {
+
+// Aggregation over many recordings: filter with predicates, bucket rows by one
+// or more columns and fold count/sum/min/max/avg per bucket. Work is split into
+// (file, chunk) units whose partial results merge associatively, which is what
+// lets the tool scan chunks in parallel and cache one partial per file.
+struct Aggregate {
+    enum class Fn { kCount, kSum, kMin, kMax, kAvg };
+
+    Fn fn{Fn::kCount};
+    int column{-1};
+
+    // "count", "sum:fuel", "min:y", "max:speed", "avg:fuel"
+    static bool parse(const std::string &text, Aggregate &out) {
+        if (text == "count") {
+            out.fn = Fn::kCount;
+            out.column = telemetry::kTick;
+            return true;
+        }
+        const std::size_t colon = text.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        const std::string fn = text.substr(0, colon);
+        if (fn == "sum") {
+            out.fn = Fn::kSum;
+        } else if (fn == "min") {
+            out.fn = Fn::kMin;
+        } else if (fn == "max") {
+            out.fn = Fn::kMax;
+        } else if (fn == "avg") {
+            out.fn = Fn::kAvg;
+        } else {
+            return false;
+        }
+        out.column = telemetry::columnIndex(text.substr(colon + 1));
+        return out.column >= 0;
+    }
+
+    std::string label() const {
+        static const char *const kNames[] = {"count", "sum", "min", "max", "avg"};
+        std::string result = kNames[static_cast<int>(fn)];
+        if (fn != Fn::kCount) {
+            result += std::string(":") + telemetry::kColumnNames[column];
+        }
+        return result;
+    }
+};
+
+// Bucketed grouping column, e.g. "score:100" or "x:250".
+struct GroupBy {
+    int column{-1};
+    double bucket{1.0};
+
+    static bool parse(const std::string &text, GroupBy &out) {
+        const std::size_t colon = text.find(':');
+        out.column = telemetry::columnIndex(text.substr(0, colon));
+        out.bucket = 1.0;
+        if (colon != std::string::npos) {
+            char *end = nullptr;
+            out.bucket = std::strtod(text.c_str() + colon + 1, &end);
+            if (*end != '\0' || !(out.bucket > 0.0)) {
+                return false;
+            }
+        }
+        return out.column >= 0;
+    }
+
+    std::int64_t key(double value) const { return static_cast<std::int64_t>(std::floor(value / bucket)); }
+};
+
+struct QuerySpec {
+    std::vector<Predicate> predicates;
+    std::vector<GroupBy> groupBy;
+    std::vector<Aggregate> aggregates;
+    bool finalRowOnly{false};  // consider only the last recorded tick of each file
+
+    // Canonical text form; equal signatures produce identical partial results.
+    std::string signature() const {
+        std::ostringstream out;
+        out << std::setprecision(17) << "v1";
+        for (const Predicate &p : predicates) {
+            out << " w" << p.column << ':' << static_cast<int>(p.op) << ':' << p.value;
+        }
+        for (const GroupBy &g : groupBy) {
+            out << " g" << g.column << ':' << g.bucket;
+        }
+        for (const Aggregate &a : aggregates) {
+            out << " a" << static_cast<int>(a.fn) << ':' << a.column;
+        }
+        out << (finalRowOnly ? " final" : "");
+        return out.str();
+    }
+};
+
+struct GroupState {
+    std::uint64_t count{0};
+    std::vector<double> sum;
+    std::vector<double> min;
+    std::vector<double> max;
+
+    explicit GroupState(std::size_t aggregates = 0)
+        : sum(aggregates, 0.0),
+          min(aggregates, std::numeric_limits<double>::infinity()),
+          max(aggregates, -std::numeric_limits<double>::infinity()) {}
+
+    void merge(const GroupState &other) {
+        count += other.count;
+        for (std::size_t i = 0; i < sum.size(); ++i) {
+            sum[i] += other.sum[i];
+            min[i] = std::min(min[i], other.min[i]);
+            max[i] = std::max(max[i], other.max[i]);
+        }
+    }
+
+    double value(const Aggregate &aggregate, std::size_t index) const {
+        switch (aggregate.fn) {
+        case Aggregate::Fn::kCount:
+            return static_cast<double>(count);
+        case Aggregate::Fn::kSum:
+            return sum[index];
+        case Aggregate::Fn::kMin:
+            return min[index];
+        case Aggregate::Fn::kMax:
+            return max[index];
+        case Aggregate::Fn::kAvg:
+            return count > 0 ? sum[index] / static_cast<double>(count) : 0.0;
+        }
+        return 0.0;
+    }
+};
+
+using GroupKey = std::vector<std::int64_t>;
+
+struct PartialResult {
+    std::map<GroupKey, GroupState> groups;
+    std::uint64_t chunksScanned{0};
+    std::uint64_t chunksSkipped{0};
+
+    void merge(const PartialResult &other) {
+        for (const auto &[key, state] : other.groups) {
+            auto it = groups.find(key);
+            if (it == groups.end()) {
+                groups.emplace(key, state);
+            } else {
+                it->second.merge(state);
+            }
+        }
+        chunksScanned += other.chunksScanned;
+        chunksSkipped += other.chunksSkipped;
+    }
+
+    void write(std::ostream &out) const {
+        out << std::setprecision(17) << chunksScanned << ' ' << chunksSkipped << ' ' << groups.size() << '\n';
+        for (const auto &[key, state] : groups) {
+            for (const std::int64_t k : key) {
+                out << k << ' ';
+            }
+            out << state.count;
+            for (std::size_t i = 0; i < state.sum.size(); ++i) {
+                out << ' ' << state.sum[i] << ' ' << state.min[i] << ' ' << state.max[i];
+            }
+            out << '\n';
+        }
+    }
+
+    bool read(std::istream &in, const QuerySpec &spec) {
+        std::size_t groupCount = 0;
+        if (!(in >> chunksScanned >> chunksSkipped >> groupCount)) {
+            return false;
+        }
+        for (std::size_t g = 0; g < groupCount; ++g) {
+            GroupKey key(spec.groupBy.size());
+            GroupState state(spec.aggregates.size());
+            for (auto &k : key) {
+                in >> k;
+            }
+            in >> state.count;
+            for (std::size_t i = 0; i < state.sum.size(); ++i) {
+                in >> state.sum[i] >> state.min[i] >> state.max[i];
+            }
+            if (!in) {
+                return false;
+            }
+            groups.emplace(std::move(key), std::move(state));
+        }
+        return true;
+    }
+};
+
+// Folds one chunk into a partial result. With lastRowOnly the chunk must be the
+// final chunk of its file and only its last row is considered.
+inline PartialResult aggregateChunk(const QuerySpec &spec, const telemetry::ChunkHeader &chunk, bool lastRowOnly) {
+    PartialResult result;
+    std::vector<unsigned char> mask;
+    std::vector<double> scratch;
+    if (!filterChunk(chunk, spec.predicates, mask, scratch)) {
+        ++result.chunksSkipped;
+        return result;
+    }
+    ++result.chunksScanned;
+    if (lastRowOnly) {
+        std::fill(mask.begin(), mask.end() - 1, static_cast<unsigned char>(0));
+    }
+
+    // Decode every referenced column once; raw columns are read in place.
+    std::vector<std::vector<double>> buffers(telemetry::kColumnCount);
+    std::vector<const double *> columns(telemetry::kColumnCount, nullptr);
+    auto need = [&](int column) {
+        if (columns[column] == nullptr) {
+            columns[column] = TelemetryReader::column(chunk, static_cast<std::size_t>(column), buffers[column]);
+        }
+    };
+    for (const GroupBy &g : spec.groupBy) {
+        need(g.column);
+    }
+    for (const Aggregate &a : spec.aggregates) {
+        need(a.column);
+    }
+
+    GroupKey key(spec.groupBy.size());
+    for (std::size_t row = 0; row < chunk.rows; ++row) {
+        if (!mask[row]) {
+            continue;
+        }
+        for (std::size_t g = 0; g < spec.groupBy.size(); ++g) {
+            key[g] = spec.groupBy[g].key(columns[spec.groupBy[g].column][row]);
+        }
+        auto it = result.groups.find(key);
+        if (it == result.groups.end()) {
+            it = result.groups.emplace(key, GroupState(spec.aggregates.size())).first;
+        }
+        GroupState &state = it->second;
+        ++state.count;
+        for (std::size_t a = 0; a < spec.aggregates.size(); ++a) {
+            const double v = columns[spec.aggregates[a].column][row];
+            state.sum[a] += v;
+            state.min[a] = std::min(state.min[a], v);
+            state.max[a] = std::max(state.max[a], v);
+        }
+    }
+    return result;
+}
+
+// One cached partial per (query signature, file). Entries are invalidated by
+// the file's size and modification time, so re-recorded files are rescanned.
+class QueryCache {
+  public:
+    explicit QueryCache(std::string directory) : directory_(std::move(directory)) {
+        if (!directory_.empty()) {
+            std::error_code ec;
+            std::filesystem::create_directories(directory_, ec);
+        }
+    }
+
+    bool enabled() const { return !directory_.empty(); }
+
+    bool load(const QuerySpec &spec, const std::string &file, PartialResult &out) const {
+        if (!enabled()) {
+            return false;
+        }
+        std::ifstream in(entryPath(spec, file));
+        std::string signature;
+        std::string path;
+        std::string stamp;
+        if (!std::getline(in, signature) || !std::getline(in, path) || !std::getline(in, stamp)) {
+            return false;
+        }
+        if (signature != spec.signature() || path != file || stamp != fileStamp(file)) {
+            return false;
+        }
+        return out.read(in, spec);
+    }
+
+    void store(const QuerySpec &spec, const std::string &file, const PartialResult &result) const {
+        if (!enabled()) {
+            return;
+        }
+        const std::string path = entryPath(spec, file);
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            out << spec.signature() << '\n' << file << '\n' << fileStamp(file) << '\n';
+            result.write(out);
+        }
+        std::error_code ec;
+        std::filesystem::rename(path + ".tmp", path, ec);
+    }
+
+  private:
+    std::string directory_;
+
+    static std::string fileStamp(const std::string &file) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(file, ec);
+        const auto mtime = std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+        std::ostringstream out;
+        out << size << ' ' << mtime;
+        return out.str();
+    }
+
+    std::string entryPath(const QuerySpec &spec, const std::string &file) const {
+        std::uint64_t hash = 1469598103934665603ull;  // FNV-1a
+        for (const char c : spec.signature() + '\n' + file) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".qc";
+        return (std::filesystem::path(directory_) / name.str()).string();
+    }
+};
+
+}  // namespace sim
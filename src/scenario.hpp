@@ -0,0 +1,1012 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "events.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+enum class ScenarioOutcome : std::uint8_t { kRunning, kSucceeded, kFailed };
+
+// Mutable part of a running scenario. Plain data, so a batch keeps one per
+// lane next to the flight state.
+struct ScenarioState {
+    Vec3 wind{0.0, 0.0, 0.0};
+    std::uint64_t fired{0};  // `when` rules that already ran, one bit each
+    ScenarioOutcome outcome{ScenarioOutcome::kRunning};
+};
+
+// Training scenario compiled from a small line-based language:
+//
+//   name crosswind
+//   course 12 seed 7          # generated rings; without a seed, one course per episode
+//   ring 0, 90, 320, 40       # or hand-placed rings: x, y, z[, radius]
+//   start fuel 60             # x y altitude z vx vy vz yaw pitch roll (deg) throttle fuel
+//   wind 4, 0, 0              # initial wind, m/s
+//   at 100: gust 0, 6, 0      # once, on tick 100
+//   every 50: add score 5     # on ticks 50, 100, ...
+//   when altitude < 5: fail   # the first tick the condition holds
+//   while fuel < 20: wind -2, 0, 0
+//
+// Actions, separated by ';': wind X, Y, Z / gust X, Y, Z (velocity impulse) /
+// set|add fuel|throttle|score EXPR / emit TAG [EXPR] / succeed / fail.
+// Expressions use numbers, + - * / %, comparisons, and/or/not and the
+// variables tick, time, x, y, altitude, z, vx, vy, vz, speed, yaw, pitch,
+// roll, throttle, fuel, score, rings_left, rings_passed, wind_x/y/z.
+//
+// The rules compile once into 4-byte instructions for a stack machine. A
+// Scenario is immutable after compile(), so any number of episodes share one;
+// each tick run() walks the code once with a small fixed stack and no
+// allocation. Rules run in source order after the flight model; once an
+// outcome is decided the episode ends and later rules are skipped.
+//
+// `at` and `every` rules are not polled. Whoever steps the episode keeps them
+// on a TimingWheel (nextDue() gives the delay, from the start and again each
+// time one fires) and passes run() a bit per timed rule that came due on the
+// tick, which the rule's kTimerDue instruction tests.
+class Scenario {
+  public:
+    static constexpr std::size_t kStackDepth = 16;
+    static constexpr std::size_t kMaxWhenRules = 64;
+    static constexpr std::size_t kMaxTimedRules = 64;
+
+    enum class Op : std::uint8_t {
+        kPush,         // constants[b]
+        kLoad,         // variable a
+        kAdd,
+        kSub,
+        kMul,
+        kDiv,
+        kMod,
+        kNeg,
+        kLess,
+        kLessEqual,
+        kGreater,
+        kGreaterEqual,
+        kEqual,
+        kNotEqual,
+        kAnd,
+        kOr,
+        kNot,
+        kJumpIfFalse,  // to b
+        kSkipIfFired,  // to b if `when` rule a already ran
+        kMarkFired,    // rule a
+        kStore,        // variable a
+        kWind,
+        kGust,
+        kEmit,         // tag b
+        kSucceed,
+        kFail,
+        kHalt,
+        kTimerDue,     // timed rule a came due this tick
+        // Superinstructions for the common rule shapes.
+        kVarLess,        // variable a < constants[b], and so on
+        kVarLessEqual,
+        kVarGreater,
+        kVarGreaterEqual,
+        kVarEqual,
+        kVarNotEqual,
+    };
+
+    struct Instruction {
+        Op op{Op::kHalt};
+        std::uint8_t a{0};
+        std::uint16_t b{0};
+    };
+
+    static bool compile(const std::string &source, Scenario &out, std::string &error) {
+        Scenario scenario;
+        Compiler compiler(scenario);
+        if (!compiler.run(source, error)) {
+            return false;
+        }
+        out = std::move(scenario);
+        return true;
+    }
+
+    static bool load(const std::string &path, Scenario &out, std::string &error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "파일을 열 수 없습니다: " + path;
+            return false;
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+        return compile(text.str(), out, error);
+    }
+
+    const std::string &name() const { return name_; }
+    const FlightState &initialState() const { return start_; }
+    ScenarioState initialScenarioState() const { return {wind_, 0, ScenarioOutcome::kRunning}; }
+    const std::vector<Instruction> &code() const { return code_; }
+
+    // `at` and `every` rules in source order; kTimerDue a refers to rule a.
+    std::size_t timedRules() const { return timers_.size(); }
+
+    // Ticks from step `tick` until timed rule `rule` next comes due, or 0 if
+    // it never does again. Owners schedule every rule with this when an
+    // episode starts (tick 0) and reschedule a rule the tick it fires.
+    std::uint64_t nextDue(std::size_t rule, std::uint64_t tick) const {
+        const TimedRule &timer = timers_[rule];
+        if (timer.repeat) {
+            return timer.ticks - tick % timer.ticks;
+        }
+        return timer.ticks > tick ? timer.ticks - tick : 0;
+    }
+
+    // Depths (z) of the first and last ring of every course this scenario
+    // flies, without generating one.
+    std::pair<double, double> courseDepths() const {
+        if (fixedCourse_) {
+            const std::size_t last = fixedCourse_->size() - 1;
+            return {fixedCourse_->z()[0], fixedCourse_->z()[last]};
+        }
+        return {Course::kSpacing, Course::kSpacing * static_cast<double>(ringCount_)};
+    }
+
+    // The scenario's own course when it places rings or fixes a seed,
+    // otherwise a fresh course from the caller's seed.
+    std::shared_ptr<const Course> course(std::uint64_t seed) const {
+        return fixedCourse_ ? fixedCourse_ : Course::generate(ringCount_, seed);
+    }
+
+    // One scenario tick, after the flight model has stepped. Bit r of due is
+    // set if timed rule r fired on this tick.
+    ScenarioOutcome run(ScenarioState &scenario, FlightState &state, const StepContext &context,
+                        EventBuffer &events, std::uint64_t due) const {
+        if (scenario.outcome != ScenarioOutcome::kRunning) {
+            return scenario.outcome;
+        }
+        double stack[kStackDepth];
+        std::size_t sp = 0;
+        const Instruction *code = code_.data();
+        for (std::size_t pc = 0;;) {
+            const Instruction in = code[pc++];
+            switch (in.op) {
+                case Op::kPush:
+                    stack[sp++] = constants_[in.b];
+                    break;
+                case Op::kLoad:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context);
+                    break;
+                case Op::kAdd:
+                    --sp;
+                    stack[sp - 1] += stack[sp];
+                    break;
+                case Op::kSub:
+                    --sp;
+                    stack[sp - 1] -= stack[sp];
+                    break;
+                case Op::kMul:
+                    --sp;
+                    stack[sp - 1] *= stack[sp];
+                    break;
+                case Op::kDiv:
+                    --sp;
+                    stack[sp - 1] /= stack[sp];
+                    break;
+                case Op::kMod:
+                    --sp;
+                    stack[sp - 1] = std::fmod(stack[sp - 1], stack[sp]);
+                    break;
+                case Op::kNeg:
+                    stack[sp - 1] = -stack[sp - 1];
+                    break;
+                case Op::kLess:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] < stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kLessEqual:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] <= stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kGreater:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] > stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kGreaterEqual:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] >= stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kEqual:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] == stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kNotEqual:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] != stack[sp] ? 1.0 : 0.0;
+                    break;
+                case Op::kAnd:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] != 0.0 && stack[sp] != 0.0 ? 1.0 : 0.0;
+                    break;
+                case Op::kOr:
+                    --sp;
+                    stack[sp - 1] = stack[sp - 1] != 0.0 || stack[sp] != 0.0 ? 1.0 : 0.0;
+                    break;
+                case Op::kNot:
+                    stack[sp - 1] = stack[sp - 1] == 0.0 ? 1.0 : 0.0;
+                    break;
+                case Op::kJumpIfFalse:
+                    if (stack[--sp] == 0.0) {
+                        pc = in.b;
+                    }
+                    break;
+                case Op::kSkipIfFired:
+                    if ((scenario.fired >> in.a) & 1u) {
+                        pc = in.b;
+                    }
+                    break;
+                case Op::kMarkFired:
+                    scenario.fired |= std::uint64_t{1} << in.a;
+                    break;
+                case Op::kStore:
+                    write(static_cast<Var>(in.a), stack[--sp], state);
+                    break;
+                case Op::kWind:
+                    sp -= 3;
+                    scenario.wind = {stack[sp], stack[sp + 1], stack[sp + 2]};
+                    break;
+                case Op::kGust:
+                    sp -= 3;
+                    state.velocity += Vec3{stack[sp], stack[sp + 1], stack[sp + 2]};
+                    break;
+                case Op::kEmit:
+                    events.push({EventType::kScenario, in.b, stack[--sp]});
+                    break;
+                case Op::kSucceed:
+                case Op::kFail:
+                    scenario.outcome = in.op == Op::kSucceed ? ScenarioOutcome::kSucceeded : ScenarioOutcome::kFailed;
+                    events.push({EventType::kScenarioEnd, 0, in.op == Op::kSucceed ? 1.0 : 0.0});
+                    return scenario.outcome;
+                case Op::kHalt:
+                    return scenario.outcome;
+                case Op::kTimerDue:
+                    stack[sp++] = (due >> in.a) & 1u ? 1.0 : 0.0;
+                    break;
+                case Op::kVarLess:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) < constants_[in.b];
+                    break;
+                case Op::kVarLessEqual:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) <= constants_[in.b];
+                    break;
+                case Op::kVarGreater:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) > constants_[in.b];
+                    break;
+                case Op::kVarGreaterEqual:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) >= constants_[in.b];
+                    break;
+                case Op::kVarEqual:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) == constants_[in.b];
+                    break;
+                case Op::kVarNotEqual:
+                    stack[sp++] = read(static_cast<Var>(in.a), scenario, state, context) != constants_[in.b];
+                    break;
+            }
+        }
+    }
+
+    void disassemble(std::ostream &out) const {
+        for (std::size_t pc = 0; pc < code_.size(); ++pc) {
+            const Instruction &in = code_[pc];
+            out << std::setw(4) << std::setfill('0') << pc << std::setfill(' ') << "  " << opName(in.op);
+            switch (in.op) {
+                case Op::kPush:
+                    out << ' ' << constants_[in.b];
+                    break;
+                case Op::kLoad:
+                case Op::kStore:
+                    out << ' ' << varName(static_cast<Var>(in.a));
+                    break;
+                case Op::kTimerDue:
+                    out << " rule " << static_cast<int>(in.a) << (timers_[in.a].repeat ? " every " : " at ")
+                        << timers_[in.a].ticks;
+                    break;
+                case Op::kVarLess:
+                case Op::kVarLessEqual:
+                case Op::kVarGreater:
+                case Op::kVarGreaterEqual:
+                case Op::kVarEqual:
+                case Op::kVarNotEqual:
+                    out << ' ' << varName(static_cast<Var>(in.a)) << ' ' << constants_[in.b];
+                    break;
+                case Op::kJumpIfFalse:
+                    out << ' ' << in.b;
+                    break;
+                case Op::kSkipIfFired:
+                    out << " rule " << static_cast<int>(in.a) << " -> " << in.b;
+                    break;
+                case Op::kMarkFired:
+                    out << " rule " << static_cast<int>(in.a);
+                    break;
+                case Op::kEmit:
+                    out << " tag " << in.b;
+                    break;
+                default:
+                    break;
+            }
+            out << '\n';
+        }
+    }
+
+  private:
+    enum class Var : std::uint8_t {
+        kTick,
+        kTime,
+        kX,
+        kY,
+        kZ,
+        kVx,
+        kVy,
+        kVz,
+        kSpeed,
+        kYaw,
+        kPitch,
+        kRoll,
+        kThrottle,
+        kFuel,
+        kScore,
+        kRingsLeft,
+        kRingsPassed,
+        kWindX,
+        kWindY,
+        kWindZ,
+    };
+
+    struct VarName {
+        const char *name;
+        Var var;
+    };
+
+    static constexpr VarName kVars[] = {
+        {"tick", Var::kTick},       {"time", Var::kTime},           {"x", Var::kX},
+        {"y", Var::kY},             {"altitude", Var::kY},          {"z", Var::kZ},
+        {"vx", Var::kVx},           {"vy", Var::kVy},               {"vz", Var::kVz},
+        {"speed", Var::kSpeed},     {"yaw", Var::kYaw},             {"pitch", Var::kPitch},
+        {"roll", Var::kRoll},       {"throttle", Var::kThrottle},   {"fuel", Var::kFuel},
+        {"score", Var::kScore},     {"rings_left", Var::kRingsLeft}, {"rings_passed", Var::kRingsPassed},
+        {"wind_x", Var::kWindX},    {"wind_y", Var::kWindY},        {"wind_z", Var::kWindZ},
+    };
+
+    struct TimedRule {
+        std::uint64_t ticks{0};  // `at` tick, or `every` period
+        bool repeat{false};
+    };
+
+    std::string name_{"scenario"};
+    FlightState start_{};
+    Vec3 wind_{0.0, 0.0, 0.0};
+    std::size_t ringCount_{6};
+    std::shared_ptr<const Course> fixedCourse_;
+    std::vector<Instruction> code_;
+    std::vector<double> constants_;
+    std::vector<TimedRule> timers_;
+
+    static double read(Var var, const ScenarioState &scenario, const FlightState &state,
+                       const StepContext &context) {
+        switch (var) {
+            case Var::kTick:
+                return static_cast<double>(context.tick);
+            case Var::kTime:
+                return static_cast<double>(context.tick) * context.dt;
+            case Var::kX:
+                return state.position.x;
+            case Var::kY:
+                return state.position.y;
+            case Var::kZ:
+                return state.position.z;
+            case Var::kVx:
+                return state.velocity.x;
+            case Var::kVy:
+                return state.velocity.y;
+            case Var::kVz:
+                return state.velocity.z;
+            case Var::kSpeed:
+                return length(state.velocity);
+            case Var::kYaw:
+                return state.yaw / kDegToRad;
+            case Var::kPitch:
+                return state.pitch / kDegToRad;
+            case Var::kRoll:
+                return state.roll / kDegToRad;
+            case Var::kThrottle:
+                return state.throttle;
+            case Var::kFuel:
+                return state.fuel;
+            case Var::kScore:
+                return static_cast<double>(state.score);
+            case Var::kRingsLeft:
+                return static_cast<double>(context.ringsLeft);
+            case Var::kRingsPassed:
+                return static_cast<double>(context.ringCount - context.ringsLeft);
+            case Var::kWindX:
+                return scenario.wind.x;
+            case Var::kWindY:
+                return scenario.wind.y;
+            case Var::kWindZ:
+                return scenario.wind.z;
+        }
+        return 0.0;
+    }
+
+    static bool writable(Var var) { return var == Var::kThrottle || var == Var::kFuel || var == Var::kScore; }
+
+    static void write(Var var, double value, FlightState &state) {
+        switch (var) {
+            case Var::kThrottle:
+                state.throttle = std::clamp(value, 0.0, 1.0);
+                break;
+            case Var::kFuel:
+                state.fuel = std::max(0.0, value);
+                break;
+            case Var::kScore:
+                state.score = static_cast<int>(std::lround(value));
+                break;
+            default:
+                break;
+        }
+    }
+
+    static const char *varName(Var var) {
+        for (const VarName &entry : kVars) {
+            if (entry.var == var) {
+                return entry.name;
+            }
+        }
+        return "?";
+    }
+
+    static const char *opName(Op op) {
+        static const char *const kNames[] = {"push", "load", "add", "sub",  "mul",   "div",   "mod",    "neg",
+                                             "lt",   "le",   "gt",  "ge",   "eq",    "ne",    "and",    "or",
+                                             "not",  "jf",   "skipfired", "markfired", "store", "wind", "gust",
+                                             "emit", "succeed", "fail", "halt", "timer",
+                                             "lt.k", "le.k", "gt.k", "ge.k", "eq.k", "ne.k"};
+        return kNames[static_cast<std::size_t>(op)];
+    }
+
+    // Recursive-descent compiler, one source line at a time.
+    class Compiler {
+      public:
+        explicit Compiler(Scenario &out) : out_(out) {}
+
+        bool run(const std::string &source, std::string &error) {
+            std::istringstream lines(source);
+            std::string text;
+            std::vector<Ring> rings;
+            bool generated = false;
+            bool seeded = false;
+            std::uint64_t seed = 0;
+
+            while (std::getline(lines, text)) {
+                ++line_;
+                const std::size_t comment = text.find('#');
+                if (comment != std::string::npos) {
+                    text.erase(comment);
+                }
+                if (!tokenize(text)) {
+                    error = error_;
+                    return false;
+                }
+                if (tokens_.size() == 1) {
+                    continue;  // blank
+                }
+                const std::string keyword = next().text;
+                bool ok = true;
+                if (keyword == "name") {
+                    ok = peek().kind == Token::kName ? (out_.name_ = next().text, true) : fail("이름이 필요합니다");
+                } else if (keyword == "course") {
+                    double count = 0.0;
+                    double value = 0.0;
+                    ok = integer(count, 1.0, 1e7);
+                    if (ok && acceptName("seed")) {
+                        ok = integer(value, 0.0, 1.8e19);
+                        seeded = true;
+                        seed = static_cast<std::uint64_t>(value);
+                    }
+                    out_.ringCount_ = static_cast<std::size_t>(count);
+                    generated = true;
+                } else if (keyword == "ring") {
+                    Ring ring{{0.0, 0.0, 0.0}, Course::kRingRadius};
+                    ok = number(ring.position.x) && expect(",") && number(ring.position.y) && expect(",") &&
+                         number(ring.position.z) && (!accept(",") || number(ring.radius));
+                    if (ok && (ring.radius <= 0.0 || ring.radius > Course::kRingRadius)) {
+                        ok = fail("링 반지름은 0보다 크고 45m 이하여야 합니다");
+                    } else if (ok && ring.position.z <= 0.0) {
+                        ok = fail("링의 z 는 0보다 커야 합니다");
+                    }
+                    rings.push_back(ring);
+                } else if (keyword == "start") {
+                    ok = start();
+                } else if (keyword == "wind") {
+                    ok = number(out_.wind_.x) && expect(",") && number(out_.wind_.y) && expect(",") &&
+                         number(out_.wind_.z);
+                } else if (keyword == "at" || keyword == "every" || keyword == "when" || keyword == "while") {
+                    ok = rule(keyword);
+                } else {
+                    ok = fail("알 수 없는 문장 '" + keyword + "'");
+                }
+                if (ok && peek().kind != Token::kEnd) {
+                    ok = fail("문장 끝에 남은 토큰 '" + peek().text + "'");
+                }
+                if (!ok) {
+                    error = error_;
+                    return false;
+                }
+            }
+            if (generated && !rings.empty()) {
+                error = "course 와 ring 은 함께 쓸 수 없습니다";
+                return false;
+            }
+            emit(Op::kHalt);
+            if (!rings.empty()) {
+                out_.ringCount_ = rings.size();
+                out_.fixedCourse_ = Course::fromRings(std::move(rings));
+            } else if (seeded) {
+                out_.fixedCourse_ = Course::generate(out_.ringCount_, seed);
+            }
+            return true;
+        }
+
+      private:
+        struct Token {
+            enum Kind { kNumber, kName, kSymbol, kEnd } kind{kEnd};
+            std::string text;
+            double number{0.0};
+        };
+
+        Scenario &out_;
+        std::vector<Token> tokens_;
+        std::size_t pos_{0};
+        std::size_t line_{0};
+        std::size_t depth_{0};
+        std::size_t whenRules_{0};
+        std::size_t ruleStart_{0};
+        std::string error_;
+
+        bool fail(const std::string &message) {
+            error_ = std::to_string(line_) + "행: " + message;
+            return false;
+        }
+
+        bool tokenize(const std::string &text) {
+            tokens_.clear();
+            pos_ = 0;
+            for (std::size_t i = 0; i < text.size();) {
+                const unsigned char c = static_cast<unsigned char>(text[i]);
+                if (std::isspace(c)) {
+                    ++i;
+                } else if (std::isdigit(c) || (c == '.' && i + 1 < text.size() && std::isdigit(text[i + 1]))) {
+                    char *end = nullptr;
+                    const double value = std::strtod(text.c_str() + i, &end);
+                    const std::size_t length = static_cast<std::size_t>(end - (text.c_str() + i));
+                    tokens_.push_back({Token::kNumber, text.substr(i, length), value});
+                    i += length;
+                } else if (std::isalpha(c) || c == '_') {
+                    std::size_t j = i;
+                    while (j < text.size() && (std::isalnum(static_cast<unsigned char>(text[j])) || text[j] == '_')) {
+                        ++j;
+                    }
+                    tokens_.push_back({Token::kName, text.substr(i, j - i), 0.0});
+                    i = j;
+                } else {
+                    static const char *const kSymbols[] = {"<=", ">=", "==", "!=", "&&", "||", "+", "-", "*", "/",
+                                                           "%",  "(",  ")",  "<",  ">",  "!",  ",", ":", ";"};
+                    bool matched = false;
+                    for (const char *symbol : kSymbols) {
+                        const std::size_t length = std::char_traits<char>::length(symbol);
+                        if (text.compare(i, length, symbol) == 0) {
+                            tokens_.push_back({Token::kSymbol, symbol, 0.0});
+                            i += length;
+                            matched = true;
+                            break;
+                        }
+                    }
+                    if (!matched) {
+                        return fail(std::string("알 수 없는 문자 '") + text[i] + "'");
+                    }
+                }
+            }
+            tokens_.push_back({Token::kEnd, "줄 끝", 0.0});
+            return true;
+        }
+
+        const Token &peek() const { return tokens_[pos_]; }
+        const Token &next() { return tokens_[pos_ < tokens_.size() - 1 ? pos_++ : pos_]; }
+
+        bool accept(const char *symbol) {
+            if (peek().kind == Token::kSymbol && peek().text == symbol) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        bool acceptName(const char *name) {
+            if (peek().kind == Token::kName && peek().text == name) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        bool expect(const char *symbol) {
+            return accept(symbol) || fail(std::string("'") + symbol + "' 가 필요합니다 ('" + peek().text + "')");
+        }
+
+        // Literal with an optional sign, for the static part of a scenario.
+        bool number(double &value) {
+            const bool negative = accept("-");
+            if (peek().kind != Token::kNumber) {
+                return fail("숫자가 필요합니다 ('" + peek().text + "')");
+            }
+            value = negative ? -next().number : next().number;
+            return true;
+        }
+
+        bool integer(double &value, double min, double max) {
+            if (!number(value)) {
+                return false;
+            }
+            if (value != std::floor(value) || value < min || value > max) {
+                return fail("정수 범위를 벗어났습니다: " + tokens_[pos_ - 1].text);
+            }
+            return true;
+        }
+
+        bool start() {
+            const std::string field = peek().text;
+            next();
+            double value = 0.0;
+            if (!number(value)) {
+                return false;
+            }
+            FlightState &s = out_.start_;
+            if (field == "x") {
+                s.position.x = value;
+            } else if (field == "y" || field == "altitude") {
+                s.position.y = value;
+            } else if (field == "z") {
+                s.position.z = value;
+            } else if (field == "vx") {
+                s.velocity.x = value;
+            } else if (field == "vy") {
+                s.velocity.y = value;
+            } else if (field == "vz") {
+                s.velocity.z = value;
+            } else if (field == "yaw") {
+                s.yaw = value * kDegToRad;
+            } else if (field == "pitch") {
+                s.pitch = value * kDegToRad;
+            } else if (field == "roll") {
+                s.roll = value * kDegToRad;
+            } else if (field == "throttle") {
+                s.throttle = std::clamp(value, 0.0, 1.0);
+            } else if (field == "fuel") {
+                s.fuel = std::max(0.0, value);
+            } else {
+                return fail("알 수 없는 시작 항목 '" + field + "'");
+            }
+            return true;
+        }
+
+        // ---- code generation -------------------------------------------------
+
+        bool emit(Op op, std::uint8_t a = 0, std::uint16_t b = 0) {
+            static const int kEffect[] = {+1, +1, -1, -1, -1, -1, -1, 0,  -1, -1, -1, -1, -1, -1, -1, -1, 0,
+                                          -1, 0,  0,  -1, -3, -3, -1, 0,  0,  0,  +1, +1, +1, +1, +1, +1, +1};
+            if (out_.code_.size() >= 0xFFFF) {
+                return fail("시나리오 코드가 너무 깁니다");
+            }
+            out_.code_.push_back({op, a, b});
+            depth_ = static_cast<std::size_t>(static_cast<long>(depth_) + kEffect[static_cast<std::size_t>(op)]);
+            return depth_ <= kStackDepth || fail("식이 너무 깊게 중첩되었습니다");
+        }
+
+        bool push(double value) {
+            std::size_t index = 0;
+            while (index < out_.constants_.size() && out_.constants_[index] != value) {
+                ++index;
+            }
+            if (index == out_.constants_.size()) {
+                if (index > 0xFFFF) {
+                    return fail("상수가 너무 많습니다");
+                }
+                out_.constants_.push_back(value);
+            }
+            return emit(Op::kPush, 0, static_cast<std::uint16_t>(index));
+        }
+
+        std::size_t here() const { return out_.code_.size(); }
+        void patch(std::size_t at) { out_.code_[at].b = static_cast<std::uint16_t>(here()); }
+
+        bool variable(Var &var) {
+            if (peek().kind == Token::kName) {
+                for (const VarName &entry : kVars) {
+                    if (peek().text == entry.name) {
+                        var = entry.var;
+                        next();
+                        return true;
+                    }
+                }
+            }
+            return fail("알 수 없는 변수 '" + peek().text + "'");
+        }
+
+        bool expression() {
+            if (!conjunction()) {
+                return false;
+            }
+            while (accept("||") || acceptName("or")) {
+                if (!conjunction() || !emit(Op::kOr)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool conjunction() {
+            if (!negation()) {
+                return false;
+            }
+            while (accept("&&") || acceptName("and")) {
+                if (!negation() || !emit(Op::kAnd)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool negation() {
+            if (accept("!") || acceptName("not")) {
+                return negation() && emit(Op::kNot);
+            }
+            return comparison();
+        }
+
+        bool comparison() {
+            static const struct {
+                const char *symbol;
+                Op op;
+            } kComparisons[] = {{"<=", Op::kLessEqual}, {">=", Op::kGreaterEqual}, {"==", Op::kEqual},
+                                {"!=", Op::kNotEqual},  {"<", Op::kLess},           {">", Op::kGreater}};
+            if (!sum()) {
+                return false;
+            }
+            for (const auto &candidate : kComparisons) {
+                if (accept(candidate.symbol)) {
+                    return sum() && emit(candidate.op) && fuseComparison();
+                }
+            }
+            return true;
+        }
+
+        // load v; push k; <cmp> becomes one <cmp>.k. Nothing jumps into the
+        // middle of a rule, so rewriting the tail of the current one is safe.
+        bool fuseComparison() {
+            std::vector<Instruction> &code = out_.code_;
+            const std::size_t n = code.size();
+            if (n < ruleStart_ + 3 || code[n - 3].op != Op::kLoad || code[n - 2].op != Op::kPush) {
+                return true;
+            }
+            const auto fused = static_cast<Op>(static_cast<int>(Op::kVarLess) + static_cast<int>(code[n - 1].op) -
+                                               static_cast<int>(Op::kLess));
+            code[n - 3] = {fused, code[n - 3].a, code[n - 2].b};
+            code.resize(n - 2);
+            return true;
+        }
+
+        bool sum() {
+            if (!product()) {
+                return false;
+            }
+            for (;;) {
+                const Op op = accept("+") ? Op::kAdd : accept("-") ? Op::kSub : Op::kHalt;
+                if (op == Op::kHalt) {
+                    return true;
+                }
+                if (!product() || !emit(op)) {
+                    return false;
+                }
+            }
+        }
+
+        bool product() {
+            if (!unary()) {
+                return false;
+            }
+            for (;;) {
+                const Op op = accept("*") ? Op::kMul : accept("/") ? Op::kDiv : accept("%") ? Op::kMod : Op::kHalt;
+                if (op == Op::kHalt) {
+                    return true;
+                }
+                if (!unary() || !emit(op)) {
+                    return false;
+                }
+            }
+        }
+
+        bool unary() {
+            if (accept("-")) {
+                if (peek().kind == Token::kNumber) {
+                    return push(-next().number);  // fold negative literals
+                }
+                return unary() && emit(Op::kNeg);
+            }
+            if (accept("(")) {
+                return expression() && expect(")");
+            }
+            if (peek().kind == Token::kNumber) {
+                return push(next().number);
+            }
+            Var var{};
+            return variable(var) && emit(Op::kLoad, static_cast<std::uint8_t>(var));
+        }
+
+        bool vector(Op op) {
+            return expression() && expect(",") && expression() && expect(",") && expression() && emit(op);
+        }
+
+        bool action() {
+            const std::string verb = peek().text;
+            next();
+            if (verb == "wind") {
+                return vector(Op::kWind);
+            }
+            if (verb == "gust") {
+                return vector(Op::kGust);
+            }
+            if (verb == "set" || verb == "add") {
+                Var var{};
+                if (!variable(var)) {
+                    return false;
+                }
+                if (!writable(var)) {
+                    return fail(std::string("'") + varName(var) + "' 는 바꿀 수 없습니다 (fuel, throttle, score 만 가능)");
+                }
+                const auto index = static_cast<std::uint8_t>(var);
+                return (verb == "set" || emit(Op::kLoad, index)) && expression() &&
+                       (verb == "set" || emit(Op::kAdd)) && emit(Op::kStore, index);
+            }
+            if (verb == "emit") {
+                double tag = 0.0;
+                if (!integer(tag, 0.0, 65535.0)) {
+                    return false;
+                }
+                const bool value = peek().kind != Token::kEnd && !(peek().kind == Token::kSymbol && peek().text == ";");
+                return (value ? expression() : push(0.0)) && emit(Op::kEmit, 0, static_cast<std::uint16_t>(tag));
+            }
+            if (verb == "succeed") {
+                return emit(Op::kSucceed);
+            }
+            if (verb == "fail") {
+                return emit(Op::kFail);
+            }
+            return fail("알 수 없는 동작 '" + verb + "'");
+        }
+
+        bool rule(const std::string &kind) {
+            std::size_t skip = 0;
+            bool once = false;
+            std::uint8_t index = 0;
+            ruleStart_ = here();
+            if (kind == "at" || kind == "every") {
+                if (out_.timers_.size() == kMaxTimedRules) {
+                    return fail("at/every 규칙은 64개까지 쓸 수 있습니다");
+                }
+                double ticks = 0.0;
+                if (!integer(ticks, 1.0, 1e15)) {
+                    return false;
+                }
+                out_.timers_.push_back({static_cast<std::uint64_t>(ticks), kind == "every"});
+                if (!emit(Op::kTimerDue, static_cast<std::uint8_t>(out_.timers_.size() - 1))) {
+                    return false;
+                }
+            } else {
+                if (kind == "when") {
+                    if (whenRules_ == kMaxWhenRules) {
+                        return fail("when 규칙은 64개까지 쓸 수 있습니다");
+                    }
+                    once = true;
+                    index = static_cast<std::uint8_t>(whenRules_++);
+                    skip = here();
+                    if (!emit(Op::kSkipIfFired, index)) {
+                        return false;
+                    }
+                }
+                if (!expression()) {
+                    return false;
+                }
+            }
+            const std::size_t jump = here();
+            if (!emit(Op::kJumpIfFalse) || !expect(":") || (once && !emit(Op::kMarkFired, index))) {
+                return false;
+            }
+            do {
+                if (!action()) {
+                    return false;
+                }
+            } while (accept(";"));
+            patch(jump);
+            if (once) {
+                patch(skip);
+            }
+            return true;
+        }
+    };
+};
+
+// Runs a compiled scenario inside Simulator::step. Owns the per-episode
+// ScenarioState; the Scenario itself is shared. Timed rules live on the
+// simulator's timing wheel as hook timers, one per rule.
+class ScenarioRunner : public StepHook {
+  public:
+    explicit ScenarioRunner(std::shared_ptr<const Scenario> scenario)
+        : scenario_(std::move(scenario)), state_(scenario_->initialScenarioState()) {}
+
+    // Becomes the simulator's step hook and schedules the timed rules from
+    // its current tick.
+    void attach(Simulator &simulator) {
+        simulator_ = &simulator;
+        simulator.setStepHook(this);
+        armTimers();
+    }
+
+    void onTimer(std::uint32_t rule) override {
+        due_ |= std::uint64_t{1} << rule;
+        if (const std::uint64_t ticks = scenario_->nextDue(rule, simulator_->tick())) {
+            simulator_->scheduleHookTimer(ticks, rule);
+        }
+    }
+
+    void afterStep(const StepContext &step, FlightState &state, Vec3 &wind, EventBuffer &events) override {
+        scenario_->run(state_, state, step, events, due_);
+        due_ = 0;
+        wind = state_.wind;
+    }
+
+    const Vec3 &wind() const { return state_.wind; }
+    ScenarioOutcome outcome() const { return state_.outcome; }
+    const ScenarioState &state() const { return state_; }
+
+    // After Simulator::restore, which drops pending timers: the timed rules
+    // are scheduled again from the restored tick.
+    void restore(const ScenarioState &state) {
+        state_ = state;
+        due_ = 0;
+        armTimers();
+    }
+
+  private:
+    std::shared_ptr<const Scenario> scenario_;
+    ScenarioState state_;
+    Simulator *simulator_{nullptr};
+    std::uint64_t due_{0};  // timed rules that fired this tick
+
+    void armTimers() {
+        if (simulator_ == nullptr) {
+            return;
+        }
+        for (std::size_t rule = 0; rule < scenario_->timedRules(); ++rule) {
+            if (const std::uint64_t ticks = scenario_->nextDue(rule, simulator_->tick())) {
+                simulator_->scheduleHookTimer(ticks, static_cast<std::uint32_t>(rule));
+            }
+        }
+    }
+};
+
+}  // namespace sim
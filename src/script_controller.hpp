@@ -0,0 +1,273 @@
+#pragma once
+
+// Coroutine controller scripts. Needs C++20 coroutines (configure with
+// -DFLIGHTSIM_COROUTINES=ON); otherwise this header only defines
+// SIM_HAS_COROUTINES as 0.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define SIM_HAS_COROUTINES 1
+#endif
+#endif
+#ifndef SIM_HAS_COROUTINES
+#define SIM_HAS_COROUTINES 0
+#endif
+
+#if SIM_HAS_COROUTINES
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "batch.hpp"
+#include "controller.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+class Pilot;
+
+// Return type of a controller script: a coroutine taking the Pilot it flies,
+// started through Pilot::start, e.g.
+//
+//   ControllerScript climbAndCruise(Pilot &pilot) {
+//       co_await pilot.until([&] { return pilot.state().position.y > 150.0; });
+//       pilot.command().pitchDelta = -kMaxPitchDelta;
+//       co_await pilot.ticks(20);
+//   }
+//
+// The frame is allocated from the pilot's frame resource rather than the
+// global heap. Scripts must not throw.
+class ControllerScript {
+  public:
+    struct promise_type {
+        ControllerScript get_return_object() {
+            return ControllerScript(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        // Frames come from the resource Pilot::start installs while it calls
+        // the script; the resource is remembered in a header in front of the
+        // frame for operator delete.
+        static void *operator new(std::size_t size) {
+            std::pmr::memory_resource *resource = allocatingFrames != nullptr ? allocatingFrames
+                                                                               : std::pmr::new_delete_resource();
+            auto *block = static_cast<unsigned char *>(resource->allocate(size + kHeader, alignof(std::max_align_t)));
+            ::new (block) std::pmr::memory_resource *(resource);
+            return block + kHeader;
+        }
+
+        static void operator delete(void *frame, std::size_t size) {
+            auto *block = static_cast<unsigned char *>(frame) - kHeader;
+            (*reinterpret_cast<std::pmr::memory_resource **>(block))
+                ->deallocate(block, size + kHeader, alignof(std::max_align_t));
+        }
+
+      private:
+        friend class Pilot;
+
+        static constexpr std::size_t kHeader = alignof(std::max_align_t);
+        static inline thread_local std::pmr::memory_resource *allocatingFrames = nullptr;
+    };
+
+    ControllerScript() = default;
+    ControllerScript(ControllerScript &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    ControllerScript &operator=(ControllerScript &&other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ControllerScript(const ControllerScript &) = delete;
+    ControllerScript &operator=(const ControllerScript &) = delete;
+    ~ControllerScript() { reset(); }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+  private:
+    friend class Pilot;
+
+    explicit ControllerScript(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// One scripted aircraft: what its script sees and commands, plus the
+// condition it is waiting for. Waiting costs one comparison (or one predicate
+// call) per tick; the coroutine is only resumed when the condition holds.
+class Pilot {
+  public:
+    explicit Pilot(std::pmr::memory_resource *frames = std::pmr::new_delete_resource()) : frames_(frames) {}
+
+    Pilot(const Pilot &) = delete;
+    Pilot &operator=(const Pilot &) = delete;
+
+    const FlightState &state() const { return *state_; }
+    const Course &course() const { return *course_; }
+    const std::uint64_t *passed() const { return passed_; }
+    std::uint64_t tick() const { return tick_; }  // ticks since the script started
+    std::size_t nextRing() const { return sim::nextRing(*state_, *course_, passed_); }
+    std::pmr::memory_resource *frames() const { return frames_; }
+
+    // This tick's command; zeroed before every tick.
+    Input &command() { return command_; }
+
+    // co_await pilot.ticks(n): resume n ticks later (at least one).
+    auto ticks(std::uint64_t n) { return TickAwaiter{*this, n > 0 ? n : 1}; }
+    auto nextTick() { return ticks(1); }
+
+    // co_await pilot.until(pred): resume on the first tick pred() holds,
+    // without suspending if it already does.
+    template <typename Pred>
+    auto until(Pred pred) {
+        return UntilAwaiter<Pred>{*this, std::move(pred)};
+    }
+
+    // Starts script(*this, args...) from its first statement on the next tick.
+    template <typename Script, typename... Args>
+    void start(Script &&script, Args &&...args) {
+        std::pmr::memory_resource *const outer = ControllerScript::promise_type::allocatingFrames;
+        ControllerScript::promise_type::allocatingFrames = frames_;
+        script_ = std::forward<Script>(script)(*this, std::forward<Args>(args)...);
+        ControllerScript::promise_type::allocatingFrames = outer;
+        wakeTick_ = 0;
+        tick_ = 0;
+        test_ = nullptr;
+    }
+
+    void stop() { script_ = ControllerScript(); }
+    bool finished() const { return script_.done(); }
+
+    // Advances one tick against the aircraft's current state and returns the
+    // command the script issued, resuming it only if its wait is over.
+    Input step(const FlightState &state, const Course &course, const std::uint64_t *passed) {
+        state_ = &state;
+        course_ = &course;
+        passed_ = passed;
+        ++tick_;
+        command_ = Input{};
+        if (script_.done()) {
+            return command_;
+        }
+        const bool ready = test_ != nullptr ? test_(predicate_) : tick_ >= wakeTick_;
+        if (ready) {
+            test_ = nullptr;
+            script_.handle_.resume();
+        }
+        return command_;
+    }
+
+  private:
+    struct TickAwaiter {
+        Pilot &pilot;
+        std::uint64_t ticks;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept { pilot.wakeTick_ = pilot.tick_ + ticks; }
+        void await_resume() const noexcept {}
+    };
+
+    template <typename Pred>
+    struct UntilAwaiter {
+        Pilot &pilot;
+        Pred pred;
+
+        bool await_ready() { return pred(); }
+        // The awaiter lives in the suspended frame, so the pilot can keep a
+        // pointer to it until the script resumes.
+        void await_suspend(std::coroutine_handle<>) noexcept {
+            pilot.test_ = [](void *self) { return static_cast<UntilAwaiter *>(self)->pred(); };
+            pilot.predicate_ = this;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::pmr::memory_resource *frames_;
+    ControllerScript script_;
+    const FlightState *state_{nullptr};
+    const Course *course_{nullptr};
+    const std::uint64_t *passed_{nullptr};
+    std::uint64_t tick_{0};
+    std::uint64_t wakeTick_{0};
+    bool (*test_)(void *){nullptr};
+    void *predicate_{nullptr};
+    Input command_{};
+};
+
+// Flies a batch with one script per live lane. Pilots are indexed by slot,
+// not lane, so a script's Pilot& stays valid when the batch compacts lanes;
+// every frame comes from one pooled resource that recycles the frames of
+// finished episodes, so a warmed-up fleet runs without heap traffic.
+// Script is any callable Script(Pilot &, std::uint32_t tag) returning a
+// ControllerScript.
+template <typename Script>
+class ScriptDriver : public BatchDriver {
+  public:
+    ScriptDriver(std::size_t lanes, Script script,
+                 std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : script_(std::move(script)), frames_(upstream), slotOfLane_(lanes, 0) {
+        pilots_.reserve(lanes);
+        free_.reserve(lanes);
+        for (std::size_t slot = 0; slot < lanes; ++slot) {
+            pilots_.push_back(std::make_unique<Pilot>(&frames_));
+            free_.push_back(lanes - 1 - slot);
+        }
+    }
+
+    void started(std::size_t lane, std::uint32_t tag, const FlightState &, const Course &,
+                 const std::uint64_t *) override {
+        const std::size_t slot = free_.back();
+        free_.pop_back();
+        slotOfLane_[lane] = slot;
+        pilots_[slot]->start(script_, tag);
+    }
+
+    Input act(std::size_t lane, const FlightState &state, const Course &course, const std::uint64_t *passed,
+              std::size_t) override {
+        return pilots_[slotOfLane_[lane]]->step(state, course, passed);
+    }
+
+    bool stepped(std::size_t, const FlightState &, const Course &, const std::uint64_t *) override { return true; }
+
+    void finished(std::size_t lane, std::uint32_t, const FlightState &state) override {
+        const std::size_t slot = slotOfLane_[lane];
+        pilots_[slot]->stop();
+        free_.push_back(slot);
+        ++episodes_;
+        score_ += state.score;
+    }
+
+    void moved(std::size_t from, std::size_t to) override { slotOfLane_[to] = slotOfLane_[from]; }
+
+    std::uint64_t episodes() const { return episodes_; }
+    std::int64_t totalScore() const { return score_; }
+
+  private:
+    Script script_;
+    std::pmr::unsynchronized_pool_resource frames_;
+    std::vector<std::unique_ptr<Pilot>> pilots_;
+    std::vector<std::size_t> free_;
+    std::vector<std::size_t> slotOfLane_;
+    std::uint64_t episodes_{0};
+    std::int64_t score_{0};
+};
+
+}  // namespace sim
+
+#endif  // SIM_HAS_COROUTINES
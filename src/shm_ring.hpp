@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIM_HAS_SHM 1
+#else
+#define SIM_HAS_SHM 0
+#endif
+
+#include "simulator.hpp"
+
+namespace sim {
+
+// Live flight state in POSIX shared memory, for local dashboards:
+//
+//   Header           capacity, records published so far, writer state
+//   Slot[capacity]   record n lives in slot n % capacity
+//
+// One process publishes; any number of readers map the segment read-only, so
+// they cannot slow or corrupt the publisher. Each slot is a seqlock: its
+// sequence is 2n+1 while record n is being written and 2n+2 once it is
+// complete. A reader copies the words and keeps the copy only if the
+// sequence was the same even value before and after; a reader that falls a
+// whole ring behind sees a newer sequence and skips ahead.
+namespace shm {
+
+constexpr std::uint32_t kMagic = 0x52535346;  // "FSSR"
+constexpr std::uint32_t kVersion = 1;
+constexpr const char *kDefaultName = "/flightsim";
+
+struct Record {
+    std::uint64_t tick{0};
+    Vec3 position{0.0, 0.0, 0.0};
+    Vec3 velocity{0.0, 0.0, 0.0};
+    double yaw{0.0};
+    double pitch{0.0};
+    double roll{0.0};
+    double throttle{0.0};
+    double fuel{0.0};
+    std::int64_t score{0};
+    std::uint64_t ringsLeft{0};
+};
+
+constexpr std::size_t kRecordWords = (sizeof(Record) + 7) / 8;
+
+static_assert(std::is_trivially_copyable_v<Record>, "records are copied word by word");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "the seqlock needs lock-free atomics to work across processes");
+
+// Written as relaxed atomics so concurrent reads are well defined; on the
+// usual 64-bit targets these are plain loads and stores.
+struct alignas(64) Slot {
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> words[kRecordWords];
+};
+
+struct alignas(64) Header {
+    std::atomic<std::uint32_t> magic;  // stored last; readers check it first
+    std::uint32_t version;
+    std::uint32_t capacity;  // power of two
+    std::uint32_t recordBytes;
+    std::atomic<std::uint64_t> published;  // records written so far
+    std::atomic<std::uint32_t> closed;     // 1 once the publisher has exited
+};
+
+inline std::size_t segmentBytes(std::uint32_t capacity) { return sizeof(Header) + std::size_t{capacity} * sizeof(Slot); }
+
+inline Record toRecord(std::uint64_t tick, const FlightState &state, std::size_t ringsLeft) {
+    Record record;
+    record.tick = tick;
+    record.position = state.position;
+    record.velocity = state.velocity;
+    record.yaw = state.yaw;
+    record.pitch = state.pitch;
+    record.roll = state.roll;
+    record.throttle = state.throttle;
+    record.fuel = state.fuel;
+    record.score = state.score;
+    record.ringsLeft = ringsLeft;
+    return record;
+}
+
+}  // namespace shm
+
+// Creates the segment and appends one record per call. publish() is a handful
+// of stores into memory that is already mapped: no syscalls, no locks and no
+// waiting for readers.
+class ShmPublisher {
+  public:
+    // capacity is rounded up to a power of two.
+    ShmPublisher(const std::string &name, std::uint32_t capacity = 4096) : name_(name) {
+#if SIM_HAS_SHM
+        std::uint32_t slots = 1;
+        while (slots < capacity) {
+            slots <<= 1;
+        }
+        bytes_ = shm::segmentBytes(slots);
+        // A fresh object rather than truncating an old one under readers
+        // that still map it.
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            return;
+        }
+        void *memory = ::ftruncate(fd, static_cast<off_t>(bytes_)) == 0
+                           ? ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                           : MAP_FAILED;
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            return;
+        }
+        // ftruncate zero-fills, which is a valid initial state for every atomic.
+        header_ = static_cast<shm::Header *>(memory);
+        slots_ = reinterpret_cast<shm::Slot *>(static_cast<unsigned char *>(memory) + sizeof(shm::Header));
+        mask_ = slots - 1;
+        header_->capacity = slots;
+        header_->recordBytes = sizeof(shm::Record);
+        header_->version = shm::kVersion;
+        // Publishes the fields above to readers that see the magic.
+        header_->magic.store(shm::kMagic, std::memory_order_release);
+#endif
+    }
+
+    ShmPublisher(const ShmPublisher &) = delete;
+    ShmPublisher &operator=(const ShmPublisher &) = delete;
+
+    // Marks the stream closed and removes the name; readers that already
+    // mapped the segment keep it until they unmap.
+    ~ShmPublisher() {
+#if SIM_HAS_SHM
+        if (header_ != nullptr) {
+            header_->closed.store(1, std::memory_order_release);
+            ::munmap(header_, bytes_);
+            ::shm_unlink(name_.c_str());
+        }
+#endif
+    }
+
+    bool ok() const { return header_ != nullptr; }
+    const std::string &name() const { return name_; }
+    std::uint64_t published() const { return next_; }
+
+    void publish(const shm::Record &record) {
+        std::uint64_t words[shm::kRecordWords] = {};
+        std::memcpy(words, &record, sizeof(record));
+        shm::Slot &slot = slots_[next_ & mask_];
+        slot.sequence.store(2 * next_ + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < shm::kRecordWords; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * next_ + 2, std::memory_order_release);
+        ++next_;
+        header_->published.store(next_, std::memory_order_release);
+    }
+
+  private:
+    std::string name_;
+    shm::Header *header_{nullptr};
+    shm::Slot *slots_{nullptr};
+    std::size_t bytes_{0};
+    std::uint64_t mask_{0};
+    std::uint64_t next_{0};
+};
+
+// Read-only view of a publisher's segment. Reads never write shared memory.
+class ShmReader {
+  public:
+    enum class Status { kRecord, kPending, kClosed };
+
+    explicit ShmReader(const std::string &name) {
+#if SIM_HAS_SHM
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info {};
+        void *memory = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(shm::Header)) {
+            bytes_ = static_cast<std::size_t>(info.st_size);
+            memory = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        const auto *header = static_cast<const shm::Header *>(memory);
+        // The other header fields are only read once the magic says they
+        // are in place.
+        if (header->magic.load(std::memory_order_acquire) != shm::kMagic) {
+            ::munmap(memory, bytes_);
+            return;
+        }
+        const std::uint32_t capacity = header->capacity;
+        if (header->version != shm::kVersion ||
+            header->recordBytes != sizeof(shm::Record) || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            bytes_ < shm::segmentBytes(capacity)) {
+            ::munmap(memory, bytes_);
+            return;
+        }
+        header_ = header;
+        slots_ = reinterpret_cast<const shm::Slot *>(static_cast<const unsigned char *>(memory) + sizeof(shm::Header));
+        mask_ = capacity - 1;
+#else
+        (void)name;
+#endif
+    }
+
+    ShmReader(const ShmReader &) = delete;
+    ShmReader &operator=(const ShmReader &) = delete;
+
+    ~ShmReader() {
+#if SIM_HAS_SHM
+        if (header_ != nullptr) {
+            ::munmap(const_cast<shm::Header *>(header_), bytes_);
+        }
+#endif
+    }
+
+    bool ok() const { return header_ != nullptr; }
+    std::uint32_t capacity() const { return static_cast<std::uint32_t>(mask_ + 1); }
+    std::uint64_t published() const { return header_->published.load(std::memory_order_acquire); }
+    bool closed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+    std::uint64_t lost() const { return lost_; }  // records overwritten before this reader got to them
+
+    // Starts reading from the newest record rather than the oldest one kept.
+    void seekLatest() {
+        const std::uint64_t count = published();
+        next_ = count > 0 ? count - 1 : 0;
+    }
+
+    // The next record in publication order. kPending means nothing new yet;
+    // kClosed means nothing new and the publisher is gone.
+    Status next(shm::Record &out) {
+        while (true) {
+            const std::uint64_t count = published();
+            if (next_ >= count) {
+                return closed() && next_ >= published() ? Status::kClosed : Status::kPending;
+            }
+            if (count - next_ > mask_ + 1) {
+                skipTo(count - (mask_ + 1));
+            }
+            switch (read(next_, out)) {
+                case Read::kOk:
+                    ++next_;
+                    return Status::kRecord;
+                case Read::kOverwritten:
+                    skipTo(next_ + 1);
+                    break;
+                case Read::kTorn:
+                    break;
+            }
+        }
+    }
+
+  private:
+    enum class Read { kOk, kOverwritten, kTorn };
+
+    const shm::Header *header_{nullptr};
+    const shm::Slot *slots_{nullptr};
+    std::size_t bytes_{0};
+    std::uint64_t mask_{0};
+    std::uint64_t next_{0};
+    std::uint64_t lost_{0};
+
+    void skipTo(std::uint64_t record) {
+        lost_ += record - next_;
+        next_ = record;
+    }
+
+    Read read(std::uint64_t record, shm::Record &out) const {
+        const shm::Slot &slot = slots_[record & mask_];
+        const std::uint64_t stable = 2 * record + 2;
+        const std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != stable) {
+            return before > stable ? Read::kOverwritten : Read::kTorn;
+        }
+        std::uint64_t words[shm::kRecordWords];
+        for (std::size_t i = 0; i < shm::kRecordWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        if (after != stable) {
+            return Read::kOverwritten;
+        }
+        std::memcpy(&out, words, sizeof(out));
+        return Read::kOk;
+    }
+};
+
+}  // namespace sim
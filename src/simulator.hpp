@@ -0,0 +1,678 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "bits.hpp"
+#include "counter_rng.hpp"
+#include "events.hpp"
+#include "job_system.hpp"
+#include "perf_counters.hpp"
+#include "timing_wheel.hpp"
+#include "trace.hpp"
+
+namespace sim {
+
+constexpr double kDegToRad = M_PI / 180.0;
+
+struct Vec3 {
+    double x;
+    double y;
+    double z;
+
+    Vec3 operator+(const Vec3 &other) const { return {x + other.x, y + other.y, z + other.z}; }
+    Vec3 operator-(const Vec3 &other) const { return {x - other.x, y - other.y, z - other.z}; }
+    Vec3 operator*(double scalar) const { return {x * scalar, y * scalar, z * scalar}; }
+    Vec3 operator/(double scalar) const { return {x / scalar, y / scalar, z / scalar}; }
+
+    Vec3 &operator+=(const Vec3 &other) {
+        x += other.x;
+        y += other.y;
+        z += other.z;
+        return *this;
+    }
+
+    Vec3 &operator-=(const Vec3 &other) {
+        x -= other.x;
+        y -= other.y;
+        z -= other.z;
+        return *this;
+    }
+
+    Vec3 &operator*=(double scalar) {
+        x *= scalar;
+        y *= scalar;
+        z *= scalar;
+        return *this;
+    }
+};
+
+inline double dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+inline Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline double length(const Vec3 &v) { return std::sqrt(dot(v, v)); }
+
+inline Vec3 normalize(const Vec3 &v) {
+    const double len = length(v);
+    if (len < 1e-6) {
+        return {0.0, 0.0, 0.0};
+    }
+    return v / len;
+}
+
+inline Vec3 rotateX(const Vec3 &v, double radians) {
+    const double c = std::cos(radians);
+    const double s = std::sin(radians);
+    return {v.x, v.y * c - v.z * s, v.y * s + v.z * c};
+}
+
+inline Vec3 rotateY(const Vec3 &v, double radians) {
+    const double c = std::cos(radians);
+    const double s = std::sin(radians);
+    return {v.x * c + v.z * s, v.y, -v.x * s + v.z * c};
+}
+
+inline Vec3 rotateZ(const Vec3 &v, double radians) {
+    const double c = std::cos(radians);
+    const double s = std::sin(radians);
+    return {v.x * c - v.y * s, v.x * s + v.y * c, v.z};
+}
+
+inline Vec3 orientationForward(double yaw, double pitch, double roll) {
+    Vec3 forward{0.0, 0.0, 1.0};
+    forward = rotateZ(forward, roll);
+    forward = rotateX(forward, pitch);
+    forward = rotateY(forward, yaw);
+    return normalize(forward);
+}
+
+inline Vec3 orientationUp(double yaw, double pitch, double roll) {
+    Vec3 up{0.0, 1.0, 0.0};
+    up = rotateZ(up, roll);
+    up = rotateX(up, pitch);
+    up = rotateY(up, yaw);
+    return normalize(up);
+}
+
+struct Input {
+    double throttleDelta{0.0};
+    double pitchDelta{0.0};
+    double yawDelta{0.0};
+    double rollDelta{0.0};
+};
+
+struct Ring {
+    Vec3 position{};
+    double radius{40.0};
+};
+
+// Immutable ring geometry shared by every aircraft flying the same course.
+// Coordinates are stored as separate 64-byte aligned arrays (x, y, z, radius)
+// so the ring test streams through them; whether a ring has been passed is
+// per-aircraft state and lives in the Simulator, not here.
+//
+// Rings sit at a fixed z spacing; their lateral/altitude positions form a
+// blue-noise chain. Each ring is the best of a few candidates drawn inside the
+// reach of the previous ring (Mitchell's best-candidate sampling), preferring
+// the first one that keeps kMinSeparation from the recent rings, which a small
+// spatial hash over the (x, y) window finds in O(1); when none does (about 3%
+// of rings with these constants) the farthest candidate is used. Candidates
+// are built to be reachable, so the course is valid by construction and
+// nothing is ever retried.
+//
+// For parallel generation the course is cut into blocks of kBlockRings. Block
+// b starts at an anchor drawn from (seed, b) alone, and its chain is steered
+// so that it can still reach the next block's anchor in the steps it has left.
+// Ring i draws from the Philox stream keyed by (seed, i), so the course is
+// identical for every thread count. Generation also fills a z-slab grid, one
+// slab per ring spacing, so checks near a point touch a couple of slabs
+// instead of the whole course.
+class Course {
+  public:
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr double kSpacing = 320.0;  // also the slab depth
+    static constexpr double kRingRadius = 45.0;
+
+    static constexpr double kMinX = -220.0;
+    static constexpr double kMaxX = 220.0;
+    static constexpr double kMinY = 40.0;
+    static constexpr double kMaxY = 220.0;
+    static constexpr double kReachLateral = 160.0;  // per ring spacing, ~27 deg of heading change
+    static constexpr double kReachVertical = 90.0;  // per ring spacing, ~16 deg climb
+    static constexpr double kMinSeparation = 60.0;
+    static constexpr std::size_t kSeparationWindow = 4;  // recent rings a new ring keeps clear of
+    static constexpr int kCandidates = 16;
+    static constexpr std::size_t kBlockRings = 4096;
+
+    static std::shared_ptr<const Course> generate(std::size_t count, std::uint64_t seed, JobSystem *jobs = nullptr) {
+        auto course = std::shared_ptr<Course>(new Course(count, kSpacing * static_cast<double>(count)));
+        const std::size_t blocks = (count + kBlockRings - 1) / kBlockRings;
+        auto fill = [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t block = lo; block < hi; ++block) {
+                course->generateBlock(block, seed);
+            }
+        };
+        if (jobs != nullptr) {
+            jobs->parallelFor(0, blocks, 1, fill);
+        } else {
+            fill(0, blocks);
+        }
+        // Slabs past the last ring start at the end.
+        const std::size_t tail = count == 0 ? 0 : course->slabOf(kSpacing * static_cast<double>(count)) + 1;
+        std::fill(course->slabStart_.begin() + static_cast<std::ptrdiff_t>(tail), course->slabStart_.end(),
+                  static_cast<std::uint32_t>(count));
+        return course;
+    }
+
+    // Hand-placed rings, e.g. from a scenario, ordered by depth. Radii must not
+    // exceed kRingRadius, which bounds the slab search in ringsNear.
+    static std::shared_ptr<const Course> fromRings(std::vector<Ring> rings) {
+        std::sort(rings.begin(), rings.end(),
+                  [](const Ring &a, const Ring &b) { return a.position.z < b.position.z; });
+        const double depth = rings.empty() ? 0.0 : std::max(0.0, rings.back().position.z);
+        auto course = std::shared_ptr<Course>(new Course(rings.size(), depth));
+        std::size_t ring = 0;
+        for (std::size_t slab = 0; slab < course->slabStart_.size(); ++slab) {
+            while (ring < rings.size() && course->clampedSlab(rings[ring].position.z) < slab) {
+                ++ring;
+            }
+            course->slabStart_[slab] = static_cast<std::uint32_t>(ring);
+        }
+        for (std::size_t i = 0; i < rings.size(); ++i) {
+            course->set(i, rings[i]);
+        }
+        return course;
+    }
+
+    std::size_t size() const { return size_; }
+    const double *x() const { return column(0); }
+    const double *y() const { return column(1); }
+    const double *z() const { return column(2); }
+    const double *radius() const { return column(3); }
+    Ring ring(std::size_t i) const { return {{x()[i], y()[i], z()[i]}, radius()[i]}; }
+
+    // Index range [first, last) holding every ring a point at depth z can be
+    // inside of.
+    std::pair<std::size_t, std::size_t> ringsNear(double depth) const {
+        return {slabStart_[clampedSlab(depth - kRingRadius)], slabStart_[clampedSlab(depth + kRingRadius) + 1]};
+    }
+
+    // First ring that is not entirely behind depth z; every earlier ring is.
+    std::size_t firstAhead(double depth) const { return slabStart_[clampedSlab(depth - kRingRadius)]; }
+
+  private:
+    struct AlignedDelete {
+        void operator()(double *p) const { ::operator delete(p, std::align_val_t{kAlignment}); }
+    };
+
+    std::size_t size_;
+    std::size_t stride_;  // doubles per column, rounded up to a whole cache line
+    std::unique_ptr<double[], AlignedDelete> storage_;
+    // slabStart_[s] is the first ring whose centre lies in slab s or later. There
+    // is at least one slab plus a closing entry, so slab s is always
+    // [slabStart_[s], slabStart_[s + 1]).
+    std::vector<std::uint32_t> slabStart_;
+
+    // depth: z of the deepest ring, which sizes the slab index.
+    Course(std::size_t count, double depth)
+        : size_(count),
+          stride_((count + kAlignment / sizeof(double) - 1) / (kAlignment / sizeof(double)) *
+                  (kAlignment / sizeof(double))),
+          storage_(static_cast<double *>(
+              ::operator new(std::max<std::size_t>(1, 4 * stride_) * sizeof(double), std::align_val_t{kAlignment}))),
+          slabStart_(std::max<std::size_t>(1, count == 0 ? 0 : slabOf(depth) + 1) + 1, 0) {}
+
+    static std::size_t slabOf(double depth) { return static_cast<std::size_t>(depth / kSpacing); }
+
+    std::size_t clampedSlab(double depth) const {
+        if (depth <= 0.0) {
+            return 0;
+        }
+        return std::min(slabOf(depth), slabStart_.size() - 2);
+    }
+
+    const double *column(std::size_t c) const { return storage_.get() + c * stride_; }
+
+    struct Point {
+        double x;
+        double y;
+    };
+
+    // Latest ring index per cell of the (x, y) window. Cells are
+    // kMinSeparation / sqrt(2) wide, so a well-separated ring owns its cell and
+    // everything closer than kMinSeparation lies in the surrounding 5x5 cells.
+    class SeparationHash {
+      public:
+        SeparationHash() { latest_.fill(kEmpty); }
+
+        double nearest(const Course &course, Point p, std::size_t ring) const {
+            double best = std::numeric_limits<double>::infinity();
+            const int cx = cellX(p.x);
+            const int cy = cellY(p.y);
+            for (int y = std::max(0, cy - 2); y <= std::min(kCellsY - 1, cy + 2); ++y) {
+                for (int x = std::max(0, cx - 2); x <= std::min(kCellsX - 1, cx + 2); ++x) {
+                    const std::size_t other = latest_[static_cast<std::size_t>(y * kCellsX + x)];
+                    if (other == kEmpty || ring - other > kSeparationWindow) {
+                        continue;
+                    }
+                    best = std::min(best, std::hypot(course.x()[other] - p.x, course.y()[other] - p.y));
+                }
+            }
+            return best;
+        }
+
+        void insert(Point p, std::size_t ring) {
+            latest_[static_cast<std::size_t>(cellY(p.y) * kCellsX + cellX(p.x))] = ring;
+        }
+
+      private:
+        static constexpr double kCell = kMinSeparation / 1.4142135623730951;
+        static constexpr int kCellsX = static_cast<int>((kMaxX - kMinX) / kCell) + 1;
+        static constexpr int kCellsY = static_cast<int>((kMaxY - kMinY) / kCell) + 1;
+        static constexpr std::size_t kEmpty = std::numeric_limits<std::size_t>::max();
+
+        std::array<std::size_t, kCellsX * kCellsY> latest_;
+
+        static int cellX(double x) { return std::clamp(static_cast<int>((x - kMinX) / kCell), 0, kCellsX - 1); }
+        static int cellY(double y) { return std::clamp(static_cast<int>((y - kMinY) / kCell), 0, kCellsY - 1); }
+    };
+
+    static Point clampToWindow(Point p) { return {std::clamp(p.x, kMinX, kMaxX), std::clamp(p.y, kMinY, kMaxY)}; }
+
+    // Distance in "ring steps": 1 is exactly the reach between consecutive rings.
+    static double steps(Point a, Point b) {
+        return std::hypot((b.x - a.x) / kReachLateral, (b.y - a.y) / kReachVertical);
+    }
+
+    // A uniformly drawn point within one step of `from`, inside the window.
+    // Clamping to the window only shortens the step because `from` is inside.
+    static Point candidateNear(Point from, CounterRng &rng) {
+        const double r = std::sqrt(rng.uniform());
+        const double angle = 2.0 * M_PI * rng.uniform();
+        return clampToWindow({from.x + r * std::cos(angle) * kReachLateral, from.y + r * std::sin(angle) * kReachVertical});
+    }
+
+    // Block b's first ring. Ring 0 is within reach of the aircraft's start.
+    static Point anchor(std::size_t block, std::uint64_t seed) {
+        CounterRng rng(seed, (std::uint64_t{1} << 62) | block);
+        if (block == 0) {
+            return candidateNear({0.0, 80.0}, rng);
+        }
+        return {rng.uniform(kMinX, kMaxX), rng.uniform(kMinY, kMaxY)};
+    }
+
+    // Moves candidate c (within a step of `from`) the least distance towards
+    // the step from `from` straight at `target` so that `target` stays within
+    // `budget` steps. Both ends of that segment are within a step of `from`, so
+    // the result is too.
+    static Point keepInReach(Point from, Point c, Point target, double budget) {
+        if (steps(c, target) <= budget) {
+            return c;
+        }
+        const double gap = steps(from, target);
+        const double advance = gap > 0.0 ? std::min(1.0, gap) / gap : 0.0;
+        const Point q{from.x + (target.x - from.x) * advance, from.y + (target.y - from.y) * advance};
+        // Solve |q + t (c - q) - target| = budget for the largest t in [0, 1], in step units.
+        const double dx = (c.x - q.x) / kReachLateral;
+        const double dy = (c.y - q.y) / kReachVertical;
+        const double ex = (q.x - target.x) / kReachLateral;
+        const double ey = (q.y - target.y) / kReachVertical;
+        const double a = dx * dx + dy * dy;
+        const double b = ex * dx + ey * dy;
+        const double k = ex * ex + ey * ey - budget * budget;
+        const double t = a > 0.0 ? std::clamp((-b + std::sqrt(std::max(0.0, b * b - a * k))) / a, 0.0, 1.0) : 0.0;
+        return {q.x + (c.x - q.x) * t, q.y + (c.y - q.y) * t};
+    }
+
+    // Writes rings [b * kBlockRings, next block) and their slab entries; blocks
+    // share no state, so they can be generated concurrently.
+    void generateBlock(std::size_t block, std::uint64_t seed) {
+        const std::size_t first = block * kBlockRings;
+        const std::size_t last = std::min(size_, first + kBlockRings);
+        const bool bridged = last < size_;
+        const Point target = bridged ? anchor(block + 1, seed) : Point{0.0, 0.0};
+
+        SeparationHash hash;
+        Point previous = anchor(block, seed);
+        place(first, previous, hash);
+        for (std::size_t i = first + 1; i < last; ++i) {
+            CounterRng rng(seed, i);
+            Point best = previous;
+            double bestDistance = -1.0;
+            for (int k = 0; k < kCandidates; ++k) {
+                Point c = candidateNear(previous, rng);
+                if (bridged) {
+                    c = keepInReach(previous, c, target, static_cast<double>(last - i));
+                }
+                const double distance = hash.nearest(*this, c, i);
+                if (distance > bestDistance) {
+                    best = c;
+                    bestDistance = distance;
+                }
+                if (distance >= kMinSeparation) {
+                    break;
+                }
+            }
+            place(i, best, hash);
+            previous = best;
+        }
+    }
+
+    // Touches only ring i's columns and the slab entries between ring i - 1's
+    // slab and its own.
+    void place(std::size_t i, Point p, SeparationHash &hash) {
+        const double z = kSpacing * static_cast<double>(i + 1);
+        set(i, {{p.x, p.y, z}, kRingRadius});
+        hash.insert(p, i);
+
+        const std::size_t first = i == 0 ? 0 : slabOf(kSpacing * static_cast<double>(i)) + 1;
+        for (std::size_t slab = first; slab <= slabOf(z); ++slab) {
+            slabStart_[slab] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    void set(std::size_t i, const Ring &ring) {
+        double *base = storage_.get();
+        base[i] = ring.position.x;
+        base[stride_ + i] = ring.position.y;
+        base[2 * stride_ + i] = ring.position.z;
+        base[3 * stride_ + i] = ring.radius;
+    }
+};
+
+struct FlightState {
+    Vec3 position{0.0, 80.0, 0.0};
+    Vec3 velocity{0.0, 0.0, 30.0};
+    double yaw{0.0};
+    double pitch{0.0};
+    double roll{0.0};
+    double throttle{0.4};
+    double fuel{120.0};
+    int score{0};
+};
+
+// Flight model shared by Simulator and the batch stepper; every function
+// advances one aircraft's state in place and reports what happened through
+// the tick's EventBuffer rather than applying game rules itself.
+namespace physics {
+
+inline void applyInput(FlightState &state, const Input &input) {
+    state.throttle = std::clamp(state.throttle + input.throttleDelta, 0.0, 1.0);
+    state.pitch = std::clamp(state.pitch + input.pitchDelta, -45.0 * kDegToRad, 45.0 * kDegToRad);
+    state.yaw += input.yawDelta;
+    state.roll = std::clamp(state.roll + input.rollDelta, -80.0 * kDegToRad, 80.0 * kDegToRad);
+}
+
+// Drag and lift act on the airspeed, i.e. the velocity relative to the wind.
+inline void integrate(FlightState &state, double dt, EventBuffer &events, const Vec3 &wind = {}) {
+    constexpr double mass = 750.0;                   // kg
+    constexpr double thrustPower = 26000.0;          // N
+    constexpr double dragCoefficient = 0.04;         // simplified quadratic drag
+    constexpr double liftCoefficient = 0.018;        // scales with speed^2
+    constexpr double gravity = 9.81;                 // m/s^2
+    constexpr double fuelBurnPerSec = 0.25;          // fuel units per second at full throttle
+    constexpr double rollYawCoupling = 0.35;         // roll adds slight yawing turn
+
+    const Vec3 forward = orientationForward(state.yaw, state.pitch, state.roll);
+    const Vec3 up = orientationUp(state.yaw, state.pitch, state.roll);
+
+    // Basic forces
+    const Vec3 thrust = forward * (thrustPower * state.throttle);
+    const Vec3 air = state.velocity - wind;
+    const double speed = length(air);
+    const Vec3 drag = air * (-dragCoefficient * speed);
+    const Vec3 lift = up * (liftCoefficient * speed * speed);
+    const Vec3 gravityForce{0.0, -mass * gravity, 0.0};
+
+    // Banked turn: roll causes gradual yaw change to mimic coordinated turns.
+    state.yaw += (state.roll * rollYawCoupling) * dt;
+
+    const Vec3 acceleration = (thrust + drag + lift + gravityForce) / mass;
+    state.velocity += acceleration * dt;
+    state.position += state.velocity * dt;
+
+    const double fuelBefore = state.fuel;
+    const double fuelUse = fuelBurnPerSec * state.throttle * dt;
+    state.fuel = std::max(0.0, state.fuel - fuelUse);
+    if (fuelBefore > kFuelLowThreshold && state.fuel <= kFuelLowThreshold) {
+        events.push({EventType::kFuelLow, 0, state.fuel});
+    }
+
+    // An empty tank cannot produce thrust; that is physics, so it stays here.
+    if (state.fuel <= 0.0) {
+        if (fuelBefore > 0.0) {
+            events.push({EventType::kFuelEmpty, 0, 0.0});
+        }
+        state.throttle = 0.0;
+    }
+}
+
+// wasAirborne is whether the tick started above the ground: contact is
+// reported when the aircraft touches down, not on every tick it sits there.
+inline void clampToGround(FlightState &state, EventBuffer &events, bool wasAirborne) {
+    if (state.position.y < 0.0) {
+        state.position.y = 0.0;
+        if (wasAirborne) {
+            events.push({EventType::kGroundContact, 0, std::min(0.0, state.velocity.y)});
+        }
+        if (state.velocity.y < 0.0) {
+            state.velocity.y *= -0.2;  // dampen bounce
+        }
+    }
+}
+
+inline bool ringPassed(const std::uint64_t *passed, std::size_t ring) { return (passed[ring / 64] >> (ring % 64)) & 1u; }
+
+// Marks every unpassed ring the aircraft is inside, one bit per ring.
+inline void checkRings(const FlightState &state, const Course &course, std::uint64_t *passed, std::size_t &remaining,
+                       EventBuffer &events) {
+    if (remaining == 0) {
+        return;
+    }
+    const double *xs = course.x();
+    const double *ys = course.y();
+    const double *zs = course.z();
+    const double *radii = course.radius();
+    const Vec3 p = state.position;
+
+    const auto [first, last] = course.ringsNear(p.z);
+    for (std::size_t i = first; i < last; ++i) {
+        const double dx = xs[i] - p.x;
+        const double dy = ys[i] - p.y;
+        const double dz = zs[i] - p.z;
+        if (dx * dx + dy * dy + dz * dz > radii[i] * radii[i] || ringPassed(passed, i)) {
+            continue;
+        }
+        passed[i / 64] |= std::uint64_t{1} << (i % 64);
+        --remaining;
+        events.push({EventType::kRingPassed, static_cast<std::uint32_t>(i), 0.0});
+    }
+}
+
+}  // namespace physics
+
+// Game rules, applied to a tick's events before any subscriber sees them.
+namespace rules {
+
+constexpr int kRingScore = 100;
+
+inline void score(const EventBuffer &events, FlightState &state) {
+    for (const Event &event : events) {
+        if (event.type == EventType::kRingPassed) {
+            state.score += kRingScore;
+        }
+    }
+}
+
+}  // namespace rules
+
+// What per-tick logic sees of the step that just ran.
+struct StepContext {
+    std::uint64_t tick{0};  // steps completed, starting at 1
+    double dt{0.0};
+    std::size_t ringsLeft{0};
+    std::size_t ringCount{0};
+};
+
+// Per-tick logic run by Simulator::step after the flight model and timers and
+// before subscribers see the tick's events (e.g. a compiled scenario). It may
+// change the flight state, the wind used by the next step, and add events.
+class StepHook {
+  public:
+    virtual ~StepHook() = default;
+
+    virtual void afterStep(const StepContext &step, FlightState &state, Vec3 &wind, EventBuffer &events) = 0;
+
+    // A timer from Simulator::scheduleHookTimer came due; called before
+    // afterStep on the same tick.
+    virtual void onTimer(std::uint32_t) {}
+};
+
+class Simulator {
+  public:
+    explicit Simulator(std::size_t ringCount)
+        : Simulator(ringCount, static_cast<unsigned int>(std::time(nullptr))) {}
+
+    // Deterministic course for a given seed; trainers rely on this to give
+    // every candidate the same set of episodes.
+    Simulator(std::size_t ringCount, unsigned int seed) : Simulator(Course::generate(ringCount, seed)) {}
+
+    // Flies a shared course. Per-aircraft ring state is one bit per ring plus a
+    // counter.
+    explicit Simulator(std::shared_ptr<const Course> course)
+        : course_(std::move(course)), passed_((course_->size() + 63) / 64, 0), remaining_(course_->size()) {}
+
+    // Starts from a given state instead of the default one (scenarios).
+    Simulator(std::shared_ptr<const Course> course, const FlightState &initial) : Simulator(std::move(course)) {
+        state_ = initial;
+    }
+
+    void step(const Input &input, double dt) {
+        SIM_TRACE_SCOPE("step");
+        SIM_PERF_SCOPE(kStep);
+        alloc::TagScope tag(alloc::kStep);
+        events_.clear();
+        const bool airborne = state_.position.y > 0.0;
+        applyInput(input);
+        integrate(dt);
+        checkRings();
+        clampToGround(airborne);
+        rules::score(events_, state_);
+        ++tick_;
+        fireTimers();
+        if (hook_ != nullptr) {
+            hook_->afterStep({tick_, dt, remaining_, course_->size()}, state_, wind_, events_);
+        }
+        bus_.publish(tick_, events_, state_);
+    }
+
+    // Scenario timer: after `ticks` more steps (at least one) the step emits a
+    // kTimer event carrying tag and value. Scheduling and cancelling are O(1),
+    // and a step only pays for the timers that come due.
+    TimerId schedule(std::uint64_t ticks, std::uint32_t tag, double value = 0.0) {
+        return timers_.scheduleIn(ticks, {tag, value, false});
+    }
+    // Same wheel, but the timer goes to the step hook's onTimer(id) instead
+    // of the event bus (e.g. a scenario's `at`/`every` rules).
+    TimerId scheduleHookTimer(std::uint64_t ticks, std::uint32_t id) {
+        return timers_.scheduleIn(ticks, {id, 0.0, true});
+    }
+    bool cancel(TimerId timer) { return timers_.cancel(timer); }
+    std::size_t pendingTimers() const { return timers_.size(); }
+
+    // Continues a saved session on the same course: flight state, ring bits
+    // (one bit per ring, as passedBits()), completed ticks and wind. Pending
+    // timers are dropped; callers schedule them again relative to the
+    // restored tick.
+    void restore(const FlightState &state, const std::uint64_t *passed, std::uint64_t tick, const Vec3 &wind) {
+        state_ = state;
+        std::copy(passed, passed + passed_.size(), passed_.begin());
+        remaining_ = course_->size();
+        for (const std::uint64_t word : passed_) {
+            remaining_ -= popcount64(word);
+        }
+        tick_ = tick;
+        wind_ = wind;
+        events_.clear();
+        timers_.reset(tick);
+    }
+
+    // Subscribers are called after every step that produced events; they must
+    // outlive the simulator or unsubscribe first.
+    bool subscribe(EventSubscriber *subscriber) { return bus_.subscribe(subscriber); }
+    // At most one hook; not owned. nullptr removes it.
+    void setStepHook(StepHook *hook) { hook_ = hook; }
+    void unsubscribe(EventSubscriber *subscriber) { bus_.unsubscribe(subscriber); }
+
+    const FlightState &state() const { return state_; }
+    const Course &course() const { return *course_; }
+    bool passed(std::size_t ring) const { return physics::ringPassed(passed_.data(), ring); }
+    const std::uint64_t *passedBits() const { return passed_.data(); }
+    std::size_t remainingRings() const { return remaining_; }
+    std::uint64_t tick() const { return tick_; }  // completed steps
+    const EventBuffer &events() const { return events_; }  // emitted by the last step
+    const Vec3 &wind() const { return wind_; }
+
+  private:
+    FlightState state_{};
+    std::uint64_t tick_{0};
+    Vec3 wind_{0.0, 0.0, 0.0};
+    EventBuffer events_;
+    EventBus bus_;
+    StepHook *hook_{nullptr};
+    std::shared_ptr<const Course> course_;
+    std::vector<std::uint64_t> passed_;
+    std::size_t remaining_;
+
+    struct TimerPayload {
+        std::uint32_t tag{0};
+        double value{0.0};
+        bool hook{false};
+    };
+    TimingWheel<TimerPayload> timers_;
+
+    void applyInput(const Input &input) { physics::applyInput(state_, input); }
+
+    void integrate(double dt) {
+        SIM_TRACE_SCOPE("integrate");
+        SIM_PERF_SCOPE(kIntegrate);
+        physics::integrate(state_, dt, events_, wind_);
+    }
+
+    void clampToGround(bool wasAirborne) {
+        SIM_TRACE_SCOPE("clampToGround");
+        SIM_PERF_SCOPE(kClampToGround);
+        physics::clampToGround(state_, events_, wasAirborne);
+    }
+
+    void fireTimers() {
+        timers_.advance(tick_, [this](std::uint64_t, const TimerPayload &timer) {
+            if (!timer.hook) {
+                events_.push({EventType::kTimer, timer.tag, timer.value});
+            } else if (hook_ != nullptr) {
+                hook_->onTimer(timer.tag);
+            }
+        });
+    }
+
+    void checkRings() {
+        SIM_TRACE_SCOPE("checkRings");
+        SIM_PERF_SCOPE(kCheckRings);
+        physics::checkRings(state_, *course_, passed_.data(), remaining_, events_);
+    }
+};
+
+}  // namespace sim
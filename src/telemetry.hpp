@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "async_file.hpp"
+#include "mapped_file.hpp"
+#include "simulator.hpp"
+
+namespace sim {
+
+// Column-oriented flight recordings. A telemetry file is a FileHeader followed by
+// self-describing chunks; each chunk stores every FlightState field as its own
+// column together with a min/max zone map, so queries can rule out whole chunks
+// from the header alone and scan the survivors as flat arrays.
+namespace telemetry {
+
+constexpr std::uint32_t kFileMagic = 0x4C545346;   // "FSTL"
+constexpr std::uint32_t kChunkMagic = 0x43545346;  // "FSTC"
+constexpr std::uint32_t kVersion = 1;
+
+enum Column : std::uint32_t {
+    kTick,
+    kPosX,
+    kPosY,
+    kPosZ,
+    kVelX,
+    kVelY,
+    kVelZ,
+    kYaw,
+    kPitch,
+    kRoll,
+    kThrottle,
+    kFuel,
+    kScore,
+    kSpeed,  // derived: |velocity|, stored so speed predicates need no recomputation
+    kColumnCount
+};
+
+constexpr std::array<const char *, kColumnCount> kColumnNames{
+    "tick", "x", "y", "z", "vx", "vy", "vz", "yaw", "pitch", "roll", "throttle", "fuel", "score", "speed"};
+
+// Resolves a column name; "altitude" is accepted as an alias for y.
+inline int columnIndex(const std::string &name) {
+    if (name == "altitude") {
+        return kPosY;
+    }
+    for (std::size_t i = 0; i < kColumnNames.size(); ++i) {
+        if (name == kColumnNames[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+enum class Encoding : std::uint32_t {
+    kRaw,       // rows doubles, 8-byte aligned, readable in place
+    kConstant,  // a single double (min == max)
+    kDelta,     // integral column: first value then zigzag varint deltas
+};
+
+struct FileHeader {
+    std::uint32_t magic{kFileMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t columns{kColumnCount};
+    std::uint32_t reserved{0};
+};
+
+struct ColumnMeta {
+    Encoding encoding{Encoding::kRaw};
+    std::uint32_t reserved{0};
+    double min{0.0};
+    double max{0.0};
+    std::uint64_t offset{0};  // from the start of the chunk header
+    std::uint64_t bytes{0};
+};
+
+struct ChunkHeader {
+    std::uint32_t magic{kChunkMagic};
+    std::uint32_t rows{0};
+    std::uint64_t bytes{0};  // whole chunk including this header
+    std::array<ColumnMeta, kColumnCount> columns{};
+};
+
+inline std::size_t align8(std::size_t value) { return (value + 7) & ~std::size_t{7}; }
+
+// Only whole numbers within +-2^53 qualify: they round-trip through int64
+// exactly and the delta between any two of them cannot overflow.
+inline bool isIntegral(const std::vector<double> &values) {
+    constexpr double kLimit = 9007199254740992.0;  // 2^53
+    for (const double v : values) {
+        if (!std::isfinite(v) || std::fabs(v) > kLimit || v != std::trunc(v)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void encodeDelta(const std::vector<double> &values, std::vector<unsigned char> &out) {
+    std::int64_t previous = 0;
+    for (const double v : values) {
+        const std::int64_t current = static_cast<std::int64_t>(v);
+        const std::int64_t delta = current - previous;
+        std::uint64_t zigzag = (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+        while (zigzag >= 0x80) {
+            out.push_back(static_cast<unsigned char>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(zigzag));
+        previous = current;
+    }
+}
+
+// Never reads past end: a damaged column decodes to garbage, not a crash.
+inline void decodeDelta(const unsigned char *data, const unsigned char *end, std::size_t rows, double *out) {
+    std::int64_t previous = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        std::uint64_t zigzag = 0;
+        int shift = 0;
+        unsigned char byte = 0;
+        do {
+            byte = data < end ? *data++ : 0;
+            if (shift < 64) {
+                zigzag |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            }
+            shift += 7;
+        } while (byte & 0x80);
+        const std::int64_t delta = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+        previous += delta;
+        out[i] = static_cast<double>(previous);
+    }
+}
+
+}  // namespace telemetry
+
+// Appends one row per tick and emits a chunk every chunkRows rows. With
+// compression enabled, constant columns collapse to one value and integral
+// columns (tick, score) are delta/varint coded; everything else stays raw so the
+// reader can scan it directly out of the mapping.
+//
+// Recording is double-buffered: the columns fill while the previous encoded
+// chunk is written asynchronously (AsyncFile). If that write is still in
+// flight when the next chunk is full, the disk is not keeping up and the new
+// chunk's rows are dropped and counted rather than making the tick wait.
+class TelemetryWriter {
+  public:
+    TelemetryWriter(const std::string &path, bool compress, std::size_t chunkRows = 4096,
+                    IoBackend backend = IoBackend::kAuto)
+        : file_(path, backend), compress_(compress), chunkRows_(chunkRows) {
+        file_.write(&fileHeader_, sizeof(fileHeader_));
+        for (auto &column : columns_) {
+            column.reserve(chunkRows_);
+        }
+    }
+
+    ~TelemetryWriter() { flush(); }
+
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+    bool ok() const { return file_.ok(); }
+    const char *backend() const { return file_.backend(); }
+    // Rows whose write has completed; the chunk in flight is counted once it
+    // lands (after flush() at the latest).
+    std::uint64_t rowsWritten() const { return written_; }
+    std::uint64_t rowsDropped() const { return dropped_; }
+
+    void record(std::uint64_t tick, const FlightState &state) {
+        using namespace telemetry;
+        columns_[kTick].push_back(static_cast<double>(tick));
+        columns_[kPosX].push_back(state.position.x);
+        columns_[kPosY].push_back(state.position.y);
+        columns_[kPosZ].push_back(state.position.z);
+        columns_[kVelX].push_back(state.velocity.x);
+        columns_[kVelY].push_back(state.velocity.y);
+        columns_[kVelZ].push_back(state.velocity.z);
+        columns_[kYaw].push_back(state.yaw);
+        columns_[kPitch].push_back(state.pitch);
+        columns_[kRoll].push_back(state.roll);
+        columns_[kThrottle].push_back(state.throttle);
+        columns_[kFuel].push_back(state.fuel);
+        columns_[kScore].push_back(static_cast<double>(state.score));
+        columns_[kSpeed].push_back(length(state.velocity));
+        if (columns_[0].size() >= chunkRows_) {
+            submitChunk();
+        }
+    }
+
+    // Writes whatever is buffered and waits until it is on file. Blocks, so
+    // it belongs at the end of a recording, not in the tick.
+    void flush() {
+        file_.wait();
+        submitChunk();
+        file_.wait();
+        settle();
+    }
+
+  private:
+    AsyncFile file_;
+    telemetry::FileHeader fileHeader_;
+    bool compress_;
+    std::size_t chunkRows_;
+    std::array<std::vector<double>, telemetry::kColumnCount> columns_;
+    std::vector<unsigned char> scratch_;
+    std::vector<unsigned char> chunk_;  // the chunk being written; reused so steady-state recording does not allocate
+    std::uint64_t written_{0};
+    std::uint64_t dropped_{0};
+    std::uint64_t inFlight_{0};  // rows of the chunk being written
+
+    // Credits the chunk in flight once its write has finished: written if it
+    // reached the file, dropped if the write failed.
+    void settle() {
+        if (inFlight_ == 0 || file_.busy()) {
+            return;
+        }
+        (file_.ok() ? written_ : dropped_) += inFlight_;
+        inFlight_ = 0;
+    }
+
+    void submitChunk() {
+        const std::size_t rows = columns_[0].size();
+        if (rows == 0) {
+            return;
+        }
+        settle();
+        if (file_.busy() || !file_.ok()) {
+            dropped_ += rows;
+        } else {
+            encodeChunk(rows);
+            if (file_.write(chunk_.data(), chunk_.size())) {
+                inFlight_ = rows;
+            } else {
+                dropped_ += rows;
+            }
+        }
+        for (auto &column : columns_) {
+            column.clear();
+        }
+    }
+
+    // Lays out header and columns in chunk_ exactly as they go on file.
+    void encodeChunk(std::size_t rows) {
+        using namespace telemetry;
+        ChunkHeader header;
+        header.rows = static_cast<std::uint32_t>(rows);
+        chunk_.assign(sizeof(header), 0);
+        std::size_t offset = align8(sizeof(header));
+
+        for (std::size_t c = 0; c < kColumnCount; ++c) {
+            const std::vector<double> &values = columns_[c];
+            ColumnMeta &meta = header.columns[c];
+            const auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+            meta.min = *lo;
+            meta.max = *hi;
+
+            scratch_.clear();
+            if (compress_ && meta.min == meta.max) {
+                meta.encoding = Encoding::kConstant;
+                appendBytes(&meta.min, sizeof(double));
+            } else if (compress_ && isIntegral(values)) {
+                meta.encoding = Encoding::kDelta;
+                encodeDelta(values, scratch_);
+            } else {
+                meta.encoding = Encoding::kRaw;
+                appendBytes(values.data(), rows * sizeof(double));
+            }
+
+            meta.offset = offset;
+            meta.bytes = scratch_.size();
+            chunk_.resize(offset + align8(scratch_.size()), 0);
+            std::memcpy(chunk_.data() + offset, scratch_.data(), scratch_.size());
+            offset = align8(offset + scratch_.size());
+        }
+
+        header.bytes = chunk_.size();
+        std::memcpy(chunk_.data(), &header, sizeof(header));
+    }
+
+    void appendBytes(const void *data, std::size_t bytes) {
+        const auto *begin = static_cast<const unsigned char *>(data);
+        scratch_.insert(scratch_.end(), begin, begin + bytes);
+    }
+};
+
+// Memory-mapped reader. Chunk headers are located once at open; column data is
+// only touched (and, for encoded columns, decoded) when a query asks for it.
+class TelemetryReader {
+  public:
+    explicit TelemetryReader(const std::string &path) {
+        using namespace telemetry;
+        if (!file_.open(path) || file_.size() < sizeof(FileHeader)) {
+            return;
+        }
+        FileHeader header;
+        std::memcpy(&header, file_.data(), sizeof(header));
+        if (header.magic != kFileMagic || header.version != kVersion || header.columns != kColumnCount) {
+            return;
+        }
+
+        // A trailing chunk cut short by a crash is ignored rather than rejected.
+        std::size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(ChunkHeader) <= file_.size()) {
+            const auto *chunk = reinterpret_cast<const ChunkHeader *>(file_.data() + offset);
+            if (chunk->magic != kChunkMagic || chunk->bytes < sizeof(ChunkHeader) ||
+                chunk->bytes > file_.size() - offset || !columnsValid(*chunk)) {
+                break;
+            }
+            chunks_.push_back(chunk);
+            rows_ += chunk->rows;
+            offset += chunk->bytes;
+        }
+        valid_ = true;
+    }
+
+    bool valid() const { return valid_; }
+    std::uint64_t rows() const { return rows_; }
+    const std::vector<const telemetry::ChunkHeader *> &chunks() const { return chunks_; }
+
+    // Pointer to rows contiguous doubles for one column of one chunk. Raw columns
+    // point into the mapping; encoded ones are expanded into scratch.
+    static const double *column(const telemetry::ChunkHeader &chunk, std::size_t index, std::vector<double> &scratch) {
+        using namespace telemetry;
+        const ColumnMeta &meta = chunk.columns[index];
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(&chunk) + meta.offset;
+        switch (meta.encoding) {
+        case Encoding::kRaw:
+            return reinterpret_cast<const double *>(data);
+        case Encoding::kConstant:
+            scratch.assign(chunk.rows, meta.min);
+            return scratch.data();
+        case Encoding::kDelta:
+            scratch.resize(chunk.rows);
+            decodeDelta(data, data + meta.bytes, chunk.rows, scratch.data());
+            return scratch.data();
+        }
+        return nullptr;
+    }
+
+  private:
+    MappedFile file_;
+    std::vector<const telemetry::ChunkHeader *> chunks_;
+
+    std::uint64_t rows_{0};
+    bool valid_{false};
+
+    // Every column must lie inside its chunk (whose size was already checked
+    // against the mapping), and raw columns must hold exactly rows aligned
+    // doubles, so column() can hand out pointers without further checks.
+    static bool columnsValid(const telemetry::ChunkHeader &chunk) {
+        using namespace telemetry;
+        for (const ColumnMeta &meta : chunk.columns) {
+            if (meta.offset < sizeof(ChunkHeader) || meta.offset > chunk.bytes ||
+                meta.bytes > chunk.bytes - meta.offset) {
+                return false;
+            }
+            switch (meta.encoding) {
+            case Encoding::kRaw:
+                if (meta.offset % alignof(double) != 0 || meta.bytes != std::uint64_t{chunk.rows} * sizeof(double)) {
+                    return false;
+                }
+                break;
+            case Encoding::kConstant:
+            case Encoding::kDelta:
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+}  // namespace sim
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "telemetry.hpp"
+
+namespace sim {
+
+// Single-column comparison such as "altitude<10" or "speed>=60".
+struct Predicate {
+    enum class Op { kLess, kLessEqual, kGreater, kGreaterEqual, kEqual };
+
+    int column{-1};
+    Op op{Op::kLess};
+    double value{0.0};
+
+    static bool parse(const std::string &text, Predicate &out) {
+        static const struct {
+            const char *token;
+            Op op;
+        } kOps[] = {{"<=", Op::kLessEqual}, {">=", Op::kGreaterEqual}, {"==", Op::kEqual},
+                    {"<", Op::kLess},       {">", Op::kGreater},       {"=", Op::kEqual}};
+
+        for (const auto &candidate : kOps) {
+            const std::size_t pos = text.find(candidate.token);
+            if (pos == std::string::npos) {
+                continue;
+            }
+            out.column = telemetry::columnIndex(text.substr(0, pos));
+            out.op = candidate.op;
+            const std::string number = text.substr(pos + std::char_traits<char>::length(candidate.token));
+            char *end = nullptr;
+            out.value = std::strtod(number.c_str(), &end);
+            return out.column >= 0 && !number.empty() && *end == '\0';
+        }
+        return false;
+    }
+
+    // Zone-map test: false means no row in the chunk can satisfy the predicate.
+    bool mayMatch(const telemetry::ColumnMeta &meta) const {
+        switch (op) {
+        case Op::kLess:
+            return meta.min < value;
+        case Op::kLessEqual:
+            return meta.min <= value;
+        case Op::kGreater:
+            return meta.max > value;
+        case Op::kGreaterEqual:
+            return meta.max >= value;
+        case Op::kEqual:
+            return meta.min <= value && value <= meta.max;
+        }
+        return true;
+    }
+
+    // ANDs this predicate into a byte mask. Each branch is a plain loop over
+    // contiguous doubles that the compiler turns into packed compares.
+    void apply(const double *values, std::size_t rows, unsigned char *mask) const {
+        const double v = value;
+        switch (op) {
+        case Op::kLess:
+            for (std::size_t i = 0; i < rows; ++i) mask[i] &= static_cast<unsigned char>(values[i] < v);
+            break;
+        case Op::kLessEqual:
+            for (std::size_t i = 0; i < rows; ++i) mask[i] &= static_cast<unsigned char>(values[i] <= v);
+            break;
+        case Op::kGreater:
+            for (std::size_t i = 0; i < rows; ++i) mask[i] &= static_cast<unsigned char>(values[i] > v);
+            break;
+        case Op::kGreaterEqual:
+            for (std::size_t i = 0; i < rows; ++i) mask[i] &= static_cast<unsigned char>(values[i] >= v);
+            break;
+        case Op::kEqual:
+            for (std::size_t i = 0; i < rows; ++i) mask[i] &= static_cast<unsigned char>(values[i] == v);
+            break;
+        }
+    }
+};
+
+struct ScanStats {
+    std::uint64_t chunksScanned{0};
+    std::uint64_t chunksSkipped{0};
+    std::uint64_t rowsMatched{0};
+};
+
+// Applies the zone maps and then the predicates to one chunk. Returns false
+// when the chunk was skipped; otherwise mask holds one byte per row.
+inline bool filterChunk(const telemetry::ChunkHeader &chunk, const std::vector<Predicate> &predicates,
+                        std::vector<unsigned char> &mask, std::vector<double> &scratch) {
+    for (const Predicate &p : predicates) {
+        if (!p.mayMatch(chunk.columns[p.column])) {
+            return false;
+        }
+    }
+    mask.assign(chunk.rows, 1);
+    for (const Predicate &p : predicates) {
+        p.apply(TelemetryReader::column(chunk, p.column, scratch), chunk.rows, mask.data());
+    }
+    return true;
+}
+
+// Scans every chunk of a recording that survives the zone maps and calls
+// onMatch(chunk, row) for each row satisfying all predicates. With
+// lastRowOnly only the recording's last row is considered, as in
+// aggregateChunk.
+template <typename OnMatch>
+ScanStats scanTelemetry(const TelemetryReader &reader, const std::vector<Predicate> &predicates, bool lastRowOnly,
+                        OnMatch &&onMatch) {
+    ScanStats stats;
+    std::vector<unsigned char> mask;
+    std::vector<double> scratch;
+
+    const auto &chunks = reader.chunks();
+    for (std::size_t c = lastRowOnly && !chunks.empty() ? chunks.size() - 1 : 0; c < chunks.size(); ++c) {
+        const telemetry::ChunkHeader *chunk = chunks[c];
+        if (!filterChunk(*chunk, predicates, mask, scratch)) {
+            ++stats.chunksSkipped;
+            continue;
+        }
+        ++stats.chunksScanned;
+        if (lastRowOnly && !mask.empty()) {
+            std::fill(mask.begin(), mask.end() - 1, static_cast<unsigned char>(0));
+        }
+        for (std::size_t row = 0; row < chunk->rows; ++row) {
+            if (mask[row]) {
+                ++stats.rowsMatched;
+                onMatch(*chunk, row);
+            }
+        }
+    }
+    return stats;
+}
+
+}  // namespace sim
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "bits.hpp"
+
+namespace sim {
+
+struct TimerId {
+    std::uint32_t index{std::numeric_limits<std::uint32_t>::max()};
+    std::uint32_t generation{0};
+
+    bool valid() const { return index != std::numeric_limits<std::uint32_t>::max(); }
+};
+
+// Hierarchical timing wheel keyed by simulation tick (Varghese & Lauck, 1987).
+// Four levels of 64 slots cover 2^24 ticks ahead of now(); later timers wait
+// in an overflow list that is re-filed each time the top level wraps. Timers
+// are nodes of intrusive lists inside one pool, so schedule and cancel are
+// O(1). Per-level occupancy bitmaps let advance() jump straight to the next
+// due slot or cascade, so its cost follows the timers that fire (plus their
+// cascades), not the number of ticks elapsed. The pool grows from the
+// given resource and recycles freed nodes, so a warmed-up wheel does not
+// allocate. Not thread-safe: each session or shard owns its own wheel.
+template <typename Payload>
+class TimingWheel {
+  public:
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr std::uint64_t kSlots = std::uint64_t{1} << kSlotBits;
+    static constexpr std::uint64_t kHorizon = std::uint64_t{1} << (kLevels * kSlotBits);
+
+    explicit TimingWheel(std::uint64_t now = 0, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : nodes_(resource), now_(now) {}
+
+    std::uint64_t now() const { return now_; }
+    std::size_t size() const { return live_; }
+    bool empty() const { return live_ == 0; }
+
+    void reserve(std::size_t timers) { nodes_.reserve(timers); }
+
+    // Drops every pending timer and restarts the clock at `now`. Node
+    // generations survive, so ids handed out earlier stay invalid.
+    void reset(std::uint64_t now) {
+        for (std::uint32_t index = 0; index < nodes_.size(); ++index) {
+            if (nodes_[index].live) {
+                release(index);
+            }
+        }
+        buckets_ = {};
+        occupied_ = {};
+        now_ = now;
+    }
+
+    // Fires during the advance that reaches tick `due`; a due tick that has
+    // already passed fires on the next tick.
+    TimerId schedule(std::uint64_t due, Payload payload) {
+        const std::uint32_t index = acquire();
+        Node &node = nodes_[index];
+        node.due = due > now_ ? due : now_ + 1;
+        node.payload = std::move(payload);
+        node.live = true;
+        ++live_;
+        file(index);
+        return {index, node.generation};
+    }
+
+    TimerId scheduleIn(std::uint64_t ticks, Payload payload) {
+        return schedule(now_ + (ticks > 0 ? ticks : 1), std::move(payload));
+    }
+
+    // False if the timer already fired or was cancelled.
+    bool cancel(TimerId id) {
+        if (!id.valid() || id.index >= nodes_.size()) {
+            return false;
+        }
+        Node &node = nodes_[id.index];
+        if (!node.live || node.generation != id.generation) {
+            return false;
+        }
+        unlink(id.index);
+        release(id.index);
+        return true;
+    }
+
+    // Moves time forward to `to`, calling fire(due, payload) for every timer
+    // that comes due, in tick order and, within a tick, in scheduling order.
+    // fire may schedule or cancel timers; anything scheduled for a tick that
+    // has been reached fires on the following tick. Returns the timers fired.
+    template <typename F>
+    std::size_t advance(std::uint64_t to, F &&fire) {
+        std::size_t fired = 0;
+        while (now_ < to) {
+            const std::uint64_t next = nextEvent();
+            if (next > to) {
+                now_ = to;
+                break;
+            }
+            now_ = next;
+            cascade();
+            const std::uint32_t slot = static_cast<std::uint32_t>(now_ & (kSlots - 1));
+            if (buckets_[slot].head == kNone) {
+                continue;
+            }
+            // Detach the slot first so fire() can cancel its neighbours.
+            buckets_[kFiring] = buckets_[slot];
+            buckets_[slot] = {};
+            occupied_[0] &= ~(std::uint64_t{1} << slot);
+            for (std::uint32_t index = buckets_[kFiring].head; index != kNone; index = nodes_[index].next) {
+                nodes_[index].bucket = kFiring;
+            }
+            for (std::uint32_t index = buckets_[kFiring].head; index != kNone; index = buckets_[kFiring].head) {
+                unlink(index);
+                const std::uint64_t due = nodes_[index].due;
+                Payload payload = std::move(nodes_[index].payload);
+                release(index);
+                fire(due, payload);
+                ++fired;
+            }
+        }
+        return fired;
+    }
+
+  private:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t kOverflow = kLevels * kSlots;
+    static constexpr std::uint32_t kFiring = kOverflow + 1;
+
+    struct Node {
+        std::uint64_t due{0};
+        Payload payload{};
+        std::uint32_t prev{kNone};
+        std::uint32_t next{kNone};
+        std::uint32_t bucket{kNone};
+        std::uint32_t generation{0};
+        bool live{false};
+    };
+
+    struct Bucket {
+        std::uint32_t head{kNone};
+        std::uint32_t tail{kNone};
+    };
+
+    std::pmr::vector<Node> nodes_;
+    std::array<Bucket, kFiring + 1> buckets_{};
+    std::array<std::uint64_t, kLevels> occupied_{};  // non-empty slots per level
+    std::uint32_t freeHead_{kNone};
+    std::size_t live_{0};
+    std::uint64_t now_;
+
+    std::uint32_t acquire() {
+        if (freeHead_ != kNone) {
+            const std::uint32_t index = freeHead_;
+            freeHead_ = nodes_[index].next;
+            return index;
+        }
+        nodes_.emplace_back();
+        return static_cast<std::uint32_t>(nodes_.size() - 1);
+    }
+
+    void release(std::uint32_t index) {
+        Node &node = nodes_[index];
+        node.live = false;
+        node.payload = Payload{};
+        ++node.generation;
+        node.prev = kNone;
+        node.bucket = kNone;
+        node.next = freeHead_;
+        freeHead_ = index;
+        --live_;
+    }
+
+    // Level k holds timers whose due tick shares every digit above k with now_;
+    // the slot is the due tick's level-k digit.
+    std::uint32_t bucketFor(std::uint64_t due) const {
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned shift = (level + 1) * kSlotBits;
+            if ((due >> shift) == (now_ >> shift)) {
+                const std::uint64_t slot = (due >> (level * kSlotBits)) & (kSlots - 1);
+                return static_cast<std::uint32_t>(level * kSlots + slot);
+            }
+        }
+        return kOverflow;
+    }
+
+    void file(std::uint32_t index) {
+        Node &node = nodes_[index];
+        node.bucket = bucketFor(node.due);
+        Bucket &bucket = buckets_[node.bucket];
+        if (node.bucket < kOverflow) {
+            occupied_[node.bucket / kSlots] |= std::uint64_t{1} << (node.bucket % kSlots);
+        }
+        node.prev = bucket.tail;
+        node.next = kNone;
+        if (bucket.tail != kNone) {
+            nodes_[bucket.tail].next = index;
+        } else {
+            bucket.head = index;
+        }
+        bucket.tail = index;
+    }
+
+    void unlink(std::uint32_t index) {
+        Node &node = nodes_[index];
+        Bucket &bucket = buckets_[node.bucket];
+        if (node.prev != kNone) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            bucket.head = node.next;
+        }
+        if (node.next != kNone) {
+            nodes_[node.next].prev = node.prev;
+        } else {
+            bucket.tail = node.prev;
+        }
+        if (bucket.head == kNone && node.bucket < kOverflow) {
+            occupied_[node.bucket / kSlots] &= ~(std::uint64_t{1} << (node.bucket % kSlots));
+        }
+        node.prev = node.next = kNone;
+    }
+
+    // Re-files the list of one bucket against the current tick.
+    void refile(std::uint32_t bucketIndex) {
+        std::uint32_t index = buckets_[bucketIndex].head;
+        buckets_[bucketIndex] = {};
+        if (bucketIndex < kOverflow) {
+            occupied_[bucketIndex / kSlots] &= ~(std::uint64_t{1} << (bucketIndex % kSlots));
+        }
+        while (index != kNone) {
+            const std::uint32_t next = nodes_[index].next;
+            file(index);
+            index = next;
+        }
+    }
+
+    // Earliest tick after now_ at which a level-0 slot is due or an occupied
+    // higher slot cascades; ticks in between have nothing to do and are
+    // skipped. Slots at or below now_'s digit on a level are always empty.
+    std::uint64_t nextEvent() const {
+        constexpr std::uint64_t kNever = std::numeric_limits<std::uint64_t>::max();
+        if (live_ == 0) {
+            return kNever;
+        }
+        std::uint64_t next = kNever;
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned shift = level * kSlotBits;
+            const unsigned digit = static_cast<unsigned>((now_ >> shift) & (kSlots - 1));
+            const std::uint64_t ahead = digit == kSlots - 1 ? 0 : occupied_[level] & (~std::uint64_t{0} << (digit + 1));
+            if (ahead != 0) {
+                const std::uint64_t base = (now_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+                next = std::min(next, base + (std::uint64_t{lowestSetBit(ahead)} << shift));
+            }
+        }
+        if (buckets_[kOverflow].head != kNone) {
+            next = std::min(next, ((now_ >> (kLevels * kSlotBits)) + 1) << (kLevels * kSlotBits));
+        }
+        return next;
+    }
+
+    // When now_ enters a new rotation of level k-1, the level-k slot for that
+    // rotation is spread over the lower levels, highest level first.
+    void cascade() {
+        if ((now_ & (kHorizon - 1)) == 0) {
+            refile(kOverflow);
+        }
+        for (unsigned level = kLevels - 1; level > 0; --level) {
+            const unsigned shift = level * kSlotBits;
+            if ((now_ & ((std::uint64_t{1} << shift) - 1)) == 0) {
+                refile(static_cast<std::uint32_t>(level * kSlots + ((now_ >> shift) & (kSlots - 1))));
+            }
+        }
+    }
+};
+
+}  // namespace sim
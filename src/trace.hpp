@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sim {
+namespace trace {
+
+// Timeline recorder that emits Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev). Each thread owns a fixed-size ring of complete events and is
+// its only writer, so recording a scope is two clock reads and a few stores; the
+// registry mutex is taken only the first time a thread records anything.
+// Sampling is per tick: when a tick is not sampled, scopes cost one
+// thread-local load.
+
+inline std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+struct Event {
+    const char *name;  // must be a string literal or otherwise outlive the recorder
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+};
+
+class ThreadBuffer {
+  public:
+    static constexpr std::size_t kCapacity = std::size_t{1} << 16;  // most recent events kept
+
+    explicit ThreadBuffer(std::uint32_t tid) : tid_(tid), slots_(new Slot[kCapacity]) {}
+
+    std::uint32_t tid() const { return tid_; }
+
+    void push(const char *name, std::uint64_t startNs, std::uint64_t durationNs) {
+        const std::uint64_t index = written_.load(std::memory_order_relaxed);
+        // Orders the count published by the previous push before the slot
+        // stores, so a snapshot that reads any of them also sees that count.
+        std::atomic_thread_fence(std::memory_order_release);
+        Slot &slot = slots_[index & (kCapacity - 1)];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.startNs.store(startNs, std::memory_order_relaxed);
+        slot.durationNs.store(durationNs, std::memory_order_relaxed);
+        written_.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies out the retained events while the owning thread may keep
+    // recording. The count is read again after the copy: events the writer
+    // may have started overwriting in the meantime are left out of the dump,
+    // so every event returned is one complete record.
+    void snapshot(std::vector<Event> &out) const {
+        const std::uint64_t written = written_.load(std::memory_order_acquire);
+        const std::uint64_t first = written > kCapacity ? written - kCapacity : 0;
+        const std::size_t base = out.size();
+        for (std::uint64_t i = first; i < written; ++i) {
+            const Slot &slot = slots_[i & (kCapacity - 1)];
+            out.push_back({slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                           slot.durationNs.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // The writer may be storing event `after` already, into the slot of
+        // event after - kCapacity.
+        const std::uint64_t after = written_.load(std::memory_order_relaxed);
+        const std::uint64_t valid = after + 1 > kCapacity ? after + 1 - kCapacity : 0;
+        if (valid > first) {
+            const auto lapped = static_cast<std::size_t>(std::min(valid, written) - first);
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(base),
+                      out.begin() + static_cast<std::ptrdiff_t>(base + lapped));
+        }
+    }
+
+  private:
+    // Relaxed atomics so a snapshot racing the writer is well defined; on
+    // the usual 64-bit targets these are plain loads and stores.
+    struct Slot {
+        std::atomic<const char *> name{nullptr};
+        std::atomic<std::uint64_t> startNs{0};
+        std::atomic<std::uint64_t> durationNs{0};
+    };
+
+    std::uint32_t tid_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::uint64_t> written_{0};
+};
+
+class Recorder {
+  public:
+    static Recorder &instance() {
+        static Recorder recorder;
+        return recorder;
+    }
+
+    void enable(std::uint32_t sampleEvery) {
+        sampleEvery_.store(std::max<std::uint32_t>(1, sampleEvery), std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Decides whether the calling thread records the tick that is starting.
+    void beginTick(std::uint64_t tick) {
+        active() = enabled() && tick % sampleEvery_.load(std::memory_order_relaxed) == 0;
+    }
+
+    static bool &active() {
+        thread_local bool sampled = false;
+        return sampled;
+    }
+
+    ThreadBuffer &localBuffer() {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(buffers_.size() + 1)));
+            buffer = buffers_.back().get();
+        }
+        return *buffer;
+    }
+
+    bool writeChromeJson(const std::string &path) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        std::vector<Event> events;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &buffer : buffers_) {
+            events.clear();
+            buffer->snapshot(events);
+            for (const Event &e : events) {
+                out << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << buffer->tid() << ",\"ts\":" << static_cast<double>(e.startNs) / 1000.0
+                    << ",\"dur\":" << static_cast<double>(e.durationNs) / 1000.0 << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+
+  private:
+    std::atomic<bool> enabled_{false};
+    std::atomic<std::uint32_t> sampleEvery_{1};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// RAII scope; records one complete ("X") event if the current tick is sampled.
+class Scope {
+  public:
+    explicit Scope(const char *name) : name_(Recorder::active() ? name : nullptr), start_(name_ ? nowNs() : 0) {}
+
+    ~Scope() {
+        if (name_ != nullptr) {
+            Recorder::instance().localBuffer().push(name_, start_, nowNs() - start_);
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const char *name_;
+    std::uint64_t start_;
+};
+
+}  // namespace trace
+}  // namespace sim
+
+#define SIM_TRACE_CONCAT_INNER(a, b) a##b
+#define SIM_TRACE_CONCAT(a, b) SIM_TRACE_CONCAT_INNER(a, b)
+#define SIM_TRACE_SCOPE(name) ::sim::trace::Scope SIM_TRACE_CONCAT(simTraceScope, __LINE__)(name)